@@ -3,8 +3,191 @@
 
 #include "FastRealtimeEndlessTerrain.h"
 #include "DrawDebugHelpers.h"
+#include "FastRealtimeTerrainStats.h"
+#include "FastRealtimeTerrainSubsystem.h"
 #include "Kismet/KismetMathLibrary.h"
 
+namespace FastRealtimeEndlessTerrain
+{
+	// Everything the tile vert kernel reads, gathered once per LOD so the vert loop never goes back to the actor
+	struct FTileVertKernelParams
+	{
+		const TArray<UFastNoiseWrapper*>* NoiseWrappers = nullptr;
+		const TArray<FFN_NoiseLayerType>* NoiseLayers = nullptr;
+
+		// Position of the tile's first vert
+		FVector2D Origin = FVector2D::ZeroVector;
+
+		// Smoothing taps are sampled offset by the actor's location
+		FVector ActorLocation = FVector::ZeroVector;
+
+		float StepSize = 0.0f;
+
+		// Distance from a vert out to each of its smoothing taps
+		float SmoothingOffset = 0.0f;
+
+		float SmoothingAlpha = 0.0f;
+
+		float TerrainDepth = 0.0f;
+
+		// Number of verts along each side
+		int32 VertRes = 0;
+	};
+
+	// Streams a tile's verts are written to
+	struct FTileVertStreams
+	{
+		TRealtimeMeshStreamBuilder<FVector3f>& Position;
+		TRealtimeMeshStreamBuilder<FRealtimeMeshTangentsHighPrecision, FRealtimeMeshTangentsNormalPrecision>& Tangents;
+		TRealtimeMeshStreamBuilder<FVector2f, FVector2DHalf>& TexCoords;
+		TRealtimeMeshStreamBuilder<FColor>& Color;
+	};
+
+	// Stages run in turn over each row of verts
+	struct FTileVertTimers
+	{
+		FTerrainStageTimer& Noise;
+		FTerrainStageTimer& Smoothing;
+		FTerrainStageTimer& Normals;
+	};
+
+	// Unsmoothed terrain height at a position
+	static FORCEINLINE float SampleTileHeight(const FTileVertKernelParams& Params, const FVector& Position)
+	{
+		return UFastNoiseLayeringFunctions::BlendNoises(Position, FVector(0.0f), *Params.NoiseWrappers, *Params.NoiseLayers) * Params.TerrainDepth;
+	}
+
+	// Blends a height toward the average of 4 taps around its position, X+- & Y+-
+	static FORCEINLINE float SmoothTileHeight(const FTileVertKernelParams& Params, const FVector2D& Position, float Height)
+	{
+		const FVector Center = FVector(Position.X, Position.Y, 0.0f) + Params.ActorLocation;
+		const float Average = (
+			SampleTileHeight(Params, Center + FVector(Params.SmoothingOffset, 0.0f, 0.0f)) +
+			SampleTileHeight(Params, Center - FVector(Params.SmoothingOffset, 0.0f, 0.0f)) +
+			SampleTileHeight(Params, Center + FVector(0.0f, Params.SmoothingOffset, 0.0f)) +
+			SampleTileHeight(Params, Center - FVector(0.0f, Params.SmoothingOffset, 0.0f))) / 4;
+		return UKismetMathLibrary::Lerp(Height, Average, Params.SmoothingAlpha);
+	}
+
+	// Terrain height at a position, smoothed if the kernel smooths
+	template <bool bSmoothing>
+	static FORCEINLINE float GetTileHeight(const FTileVertKernelParams& Params, const FVector2D& Position)
+	{
+		const float Height = SampleTileHeight(Params, FVector(Position.X, Position.Y, 0.0f));
+		if constexpr (bSmoothing)
+		{
+			return SmoothTileHeight(Params, Position, Height);
+		}
+		return Height;
+	}
+
+	/**
+	 * Writes every vert of one LOD of a tile, specialized on whether it's displaced by noise & whether it's smoothed so the
+	 * loop carries no per-vert feature tests. Without noise verts are flat & face straight up, with it normals & tangents come
+	 * from the heights one step along X & Y, so normals stay smooth across tile seams. Each row runs noise, smoothing & normals
+	 * as separate passes, so the stage timers are read per row rather than per vert.
+	 */
+	template <bool bNoise, bool bSmoothing>
+	static void BuildTileVerts(const FTileVertKernelParams& Params, FTileVertStreams& Streams, FTileVertTimers& Timers)
+	{
+		static_assert(bNoise || !bSmoothing, "Only noise displaced tiles are smoothed");
+
+		const FRealtimeMeshTangentsHighPrecision FlatTangents(FVector3f(0.0f, 0.0f, 1.0f), FVector3f(1.0f, 0.0f, 0.0f));
+
+		// Heights & tangents of the row being built, every vert is flat without noise
+		TArray<float> RowHeights;
+		TArray<FRealtimeMeshTangentsHighPrecision> RowTangents;
+		RowHeights.Init(0.0f, Params.VertRes);
+		RowTangents.Init(FlatTangents, Params.VertRes);
+
+		for (int32 Y = 0; Y < Params.VertRes; Y++)
+		{
+			// Vert positionXY = corner position + step size * vert row & column
+			auto GetVertPosXY = [&Params, Y](int32 X) { return Params.Origin + FVector2D(Params.StepSize * X, Params.StepSize * Y); };
+
+			if constexpr (bNoise)
+			{
+				// Sample the base height
+				{
+					TERRAIN_STAGE_TIMER_SCOPE(Timers.Noise);
+					for (int32 X = 0; X < Params.VertRes; X++)
+					{
+						const FVector2D VertPosXY = GetVertPosXY(X);
+						RowHeights[X] = SampleTileHeight(Params, FVector(VertPosXY.X, VertPosXY.Y, 0.0f));
+					}
+				}
+
+				// Blend the heights w/ the average of their neighbours
+				if constexpr (bSmoothing)
+				{
+					TERRAIN_STAGE_TIMER_SCOPE(Timers.Smoothing);
+					for (int32 X = 0; X < Params.VertRes; X++)
+					{
+						RowHeights[X] = SmoothTileHeight(Params, GetVertPosXY(X), RowHeights[X]);
+					}
+				}
+
+				// Calculate normals & tangents by sampling noise height at neighboring vert positions
+				// While we are taking additional noise lookup costs per-vert, this should allow smooth normals between tile seams
+				{
+					TERRAIN_STAGE_TIMER_SCOPE(Timers.Normals);
+					for (int32 X = 0; X < Params.VertRes; X++)
+					{
+						const FVector2D VertPosXY = GetVertPosXY(X);
+						const FVector2D VertPosXYf = FVector2D(static_cast<float>(VertPosXY.X), static_cast<float>(VertPosXY.Y));
+						const float NeighborHeightX = GetTileHeight<bSmoothing>(Params, VertPosXYf + FVector2D(Params.StepSize, 0.0f));
+						const float NeighborHeightY = GetTileHeight<bSmoothing>(Params, VertPosXYf + FVector2D(0.0f, Params.StepSize));
+
+						// Calculate tangent vectors with proper grid spacing
+						const FVector3f TangentX = FVector3f(Params.StepSize, 0.0f, NeighborHeightX - RowHeights[X]).GetUnsafeNormal();
+						const FVector3f TangentY = FVector3f(0.0f, Params.StepSize, NeighborHeightY - RowHeights[X]).GetUnsafeNormal();
+
+						// Calculate normal from cross product of tangents
+						const FVector3f Normal = FVector3f::CrossProduct(TangentX, TangentY).GetUnsafeNormal();
+
+						// Store tangent & normal for the row
+						RowTangents[X] = FRealtimeMeshTangentsHighPrecision(Normal, TangentX);
+					}
+				}
+			}
+
+			// Add this generated data to the stream sets. Vert color = dummy value for now, UV = XY / TerrainRes
+			for (int32 X = 0; X < Params.VertRes; X++)
+			{
+				const FVector2D VertPosXY = GetVertPosXY(X);
+				Streams.Position.Add(FVector3f(VertPosXY.X, VertPosXY.Y, RowHeights[X]));
+				Streams.Tangents.Add(RowTangents[X]);
+				Streams.Color.Add(FColor::Black);
+				Streams.TexCoords.Add(FVector2DHalf(
+					UKismetMathLibrary::SafeDivide(float(X), float(Params.VertRes - 1)),
+					UKismetMathLibrary::SafeDivide(float(Y), float(Params.VertRes - 1))));
+			}
+		}
+	}
+
+	// Writes a tile's grid of quads as 2 tris each, straight into a triangle stream of either index width
+	template <typename IndexType>
+	static void BuildTileTriangles(TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<IndexType>>& Triangles, TRealtimeMeshStreamBuilder<uint32, uint16>& Polygroups, int32 QuadRes)
+	{
+		for (int32 Y = 0; Y < QuadRes; Y++)
+		{
+			for (int32 X = 0; X < QuadRes; X++)
+			{
+				// Calculate the index of the bottom left-corner of the current cell
+				const int32 i = (Y * QuadRes) + Y + X;
+
+				// First triangle (bottom-left corner of the quad)
+				Triangles.Add(TIndex3<uint32>(i, i + QuadRes + 1, i + 1));
+				Polygroups.Add(0);
+
+				// Second triangle (top-right corner of the quad)
+				Triangles.Add(TIndex3<uint32>(i + 1, i + QuadRes + 1, i + QuadRes + 2));
+				Polygroups.Add(0);
+			}
+		}
+	}
+}
+
 AFastRealtimeEndlessTerrain::AFastRealtimeEndlessTerrain()
 {
 	// Set tick values
@@ -16,7 +199,32 @@ void AFastRealtimeEndlessTerrain::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 
-	const FDateTime LastCacheTime = FDateTime::Now();
+	TERRAIN_STAGE_SCOPE(Tick);
+
+	// Close off the recorded frame this tick is about to act on
+	if (FlightRecording.IsSet())
+	{
+		RecordingFrame.DeltaSeconds = DeltaSeconds;
+		FlightRecording->Frames.Add(MoveTemp(RecordingFrame));
+		RecordingFrame = FTerrainFlightPathFrame();
+	}
+
+	// Leave pending tiles to the terrain subsystem when it's scheduling this terrain, otherwise spend our own budget on them
+	const bool bScheduled = bUseTerrainScheduler && UFastRealtimeTerrainSubsystem::IsSchedulingEnabled(GetWorld());
+	const float BudgetUsed = bScheduled ? 0.0f : ProcessPendingWork(TileBuildTimeBudget);
+
+	// Report what's left queued & how much of the tile build budget this frame used, scheduled budgets are reported by the subsystem
+	INC_DWORD_STAT_BY(STAT_TerrainPendingTiles, PendingTerrainTiles.Num());
+	if (!bScheduled)
+	{
+		INC_FLOAT_STAT_BY(STAT_TerrainBudget, TileBuildTimeBudget);
+		INC_FLOAT_STAT_BY(STAT_TerrainBudgetUsed, BudgetUsed);
+	}
+}
+
+float AFastRealtimeEndlessTerrain::ProcessPendingWork(float BudgetMs)
+{
+	const double StartTime = FPlatformTime::Seconds();
 	bool BuildTimeExceeded = false;
 
 	while (PendingTerrainTiles.Num() != 0 && BuildTimeExceeded == false)
@@ -30,11 +238,23 @@ void AFastRealtimeEndlessTerrain::Tick(float DeltaSeconds)
 
 		// Check if the time it took to generate this tile exceeds a threshold, if so then break the loop and wait
 		// for next tick to continue generating more tiles
-		if ((FDateTime::Now() - LastCacheTime).GetTotalMilliseconds() > TileBuildTimeBudget)
+		if ((FPlatformTime::Seconds() - StartTime) * 1000.0 > BudgetMs)
 		{
 			BuildTimeExceeded = true;
 		}
 	}
+
+	return static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+float AFastRealtimeEndlessTerrain::GetPendingWorkDistance() const
+{
+	float NearestDistanceSquared = MAX_flt;
+	for (const FVector2D& TileCenter : PendingTerrainTiles)
+	{
+		NearestDistanceSquared = FMath::Min(NearestDistanceSquared, FVector2D::DistSquared(TileCenter, FVector2D(LastObserverLocation)));
+	}
+	return PendingTerrainTiles.Num() > 0 ? FMath::Sqrt(NearestDistanceSquared) : 0.0f;
 }
 
 void AFastRealtimeEndlessTerrain::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
@@ -47,8 +267,13 @@ void AFastRealtimeEndlessTerrain::PostEditChangeProperty(FPropertyChangedEvent&
 void AFastRealtimeEndlessTerrain::GenerateTerrain()
 {
 
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
 	// Clear any previously generated data
 	ClearTerrain();
+
+	// Get every LOD's grid draw order worked out on worker tasks before the first tiles are built
+	PrepareOptimizedGridOrders();
 	
 	// Initialize Realtime Mesh Simple
 	RTM = GetRealtimeMeshComponent()->InitializeRealtimeMesh<URealtimeMeshSimple>();
@@ -72,10 +297,6 @@ void AFastRealtimeEndlessTerrain::GenerateTerrain()
 	TRealtimeMeshStreamBuilder<FColor> ColorBuilder(
 		StreamSet.AddStream(FRealtimeMeshStreams::Color, GetRealtimeMeshBufferLayout<FColor>()));
 
-	// Set up a stream for tris
-	TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>> TrianglesBuilder(
-		StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint16>>()));
-
 	// Set up a stream for polygroups
 	TRealtimeMeshStreamBuilder<uint32, uint16> PolygroupsBuilder(
 		StreamSet.AddStream(FRealtimeMeshStreams::PolyGroups, GetRealtimeMeshBufferLayout<uint16>()));
@@ -84,13 +305,37 @@ void AFastRealtimeEndlessTerrain::GenerateTerrain()
 	const int32 VertReserveCount = TerrainRes + 1;//(TerrainRes + 2) * (TerrainRes + 2);
 	const int32 TriReserveCount = (VertReserveCount - 1);//((TerrainRes + 1) * (TerrainRes + 1) * 2);
 
-	// Reserve space in buffers
-	PositionBuilder.Reserve(VertReserveCount);
-	TangentBuilder.Reserve(VertReserveCount);
-	ColorBuilder.Reserve(VertReserveCount);
-	TexCoordsBuilder.Reserve(VertReserveCount);
-	TrianglesBuilder.Reserve(TriReserveCount);
-	PolygroupsBuilder.Reserve(1);
+	// Reserve space in buffers, the counts above are per side so the grid holds their squares, with 2 tris per quad
+	PositionBuilder.Reserve(VertReserveCount * VertReserveCount);
+	TangentBuilder.Reserve(VertReserveCount * VertReserveCount);
+	ColorBuilder.Reserve(VertReserveCount * VertReserveCount);
+	TexCoordsBuilder.Reserve(VertReserveCount * VertReserveCount);
+	PolygroupsBuilder.Reserve(TriReserveCount * TriReserveCount * 2);
+
+	// Set up a stream for tris, 16 bit unless the tile has more verts than 16 bit indices can address
+	TOptional<TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>>> TrianglesBuilder16;
+	TOptional<TRealtimeMeshStreamBuilder<TIndex3<uint32>>> TrianglesBuilder32;
+	if (VertReserveCount * VertReserveCount <= MAX_uint16)
+	{
+		TrianglesBuilder16.Emplace(StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint16>>()));
+		TrianglesBuilder16->Reserve(TriReserveCount * TriReserveCount * 2);
+	}
+	else
+	{
+		TrianglesBuilder32.Emplace(StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint32>>()));
+		TrianglesBuilder32->Reserve(TriReserveCount * TriReserveCount * 2);
+	}
+	auto AddTriangle = [&](const TIndex3<uint32>& Triangle)
+	{
+		if (TrianglesBuilder16.IsSet())
+		{
+			TrianglesBuilder16->Add(Triangle);
+		}
+		else
+		{
+			TrianglesBuilder32->Add(Triangle);
+		}
+	};
 
 	// Calculate step size between each vertex
 	const float StepSize = TerrainSize / (TerrainRes);
@@ -312,15 +557,21 @@ void AFastRealtimeEndlessTerrain::GenerateTerrain()
 			const int32 i = (Y * TriReserveCount) + Y + X;
 
 			// First triangle (bottom-left corner of the quad)
-			TrianglesBuilder.Add(TIndex3<uint32>(i, i + TriReserveCount + 1, i + 1));
+			AddTriangle(TIndex3<uint32>(i, i + TriReserveCount + 1, i + 1));
 			PolygroupsBuilder.Add(0);
 
 			// Second triangle (top-right corner of the quad)
-			TrianglesBuilder.Add(TIndex3<uint32>(i + 1, i + TriReserveCount + 1, i + TriReserveCount + 2));
+			AddTriangle(TIndex3<uint32>(i + 1, i + TriReserveCount + 1, i + TriReserveCount + 2));
 			PolygroupsBuilder.Add(0);
 		}
 	}
 
+	// Reorder for the vertex cache, if the grid's draw order is ready
+	if (const FTerrainMeshOptimizedOrder* OptimizedOrder = bOptimizeVertexCache ? GetOptimizedGridOrder(TriReserveCount) : nullptr)
+	{
+		FFastRealtimeTerrainMeshOptimizer::ApplyOrder(StreamSet, *OptimizedOrder);
+	}
+
 	// Setup the material slot
 	RTM->SetupMaterialSlot(0, "PrimaryMaterial");
 
@@ -336,6 +587,9 @@ void AFastRealtimeEndlessTerrain::GenerateTerrain()
 
 	// Update the configuration of the polygroup section
 	RTM->UpdateSectionConfig(PolyGroup0SectionKey, FRealtimeMeshSectionConfig(0), bDoCollision);
+
+	MemoryUsage += FTerrainMemoryUsage::ForMeshSection(VertReserveCount * VertReserveCount, TriReserveCount * TriReserveCount * 2, bDoCollision);
+	FTerrainMemoryUsage::UpdatePeak(MemoryUsage, PeakMemoryUsage);
 	
 	//Super::OnGenerateMesh_Implementation();
 
@@ -343,31 +597,41 @@ void AFastRealtimeEndlessTerrain::GenerateTerrain()
 
 void AFastRealtimeEndlessTerrain::GenerateTerrainTile(const FVector TileCenter)
 {
+	TERRAIN_STAGE_SCOPE(TileBuild);
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
 	// Cache build start time for logging
 	FDateTime StartTime = FDateTime::Now();
 
-	// Initialize a new RuntimeMeshComponent for each tile
-	URealtimeMeshComponent* NewMeshComp = NewObject<URealtimeMeshComponent>(this, URealtimeMeshComponent::StaticClass());
-	NewMeshComp->RegisterComponent();
-	NewMeshComp->SetCollisionProfileName("BlockAll");
-	GeneratedMeshComps.Add(NewMeshComp);
-	
-	// Initialize Realtime Mesh Simple
-	URealtimeMeshSimple* NRTM = NewMeshComp->InitializeRealtimeMesh<URealtimeMeshSimple>();
-
-	// Set collision settings
-	FRealtimeMeshCollisionConfiguration CollisionConfig = FRealtimeMeshCollisionConfiguration();
-	CollisionConfig.bUseAsyncCook = true;
-	CollisionConfig.bDeformableMesh = false;
-	CollisionConfig.bUseComplexAsSimpleCollision = true;
-	CollisionConfig.bMergeAllMeshes = true;
-	NRTM->SetCollisionConfig(CollisionConfig);
-		
-	// Setup the material slot
-	NRTM->SetupMaterialSlot(0, TEXT("TerrainMaterial"));
+	// Build into the tile's batch region's shared component, setting it up if this is the region's first tile, or into a new
+	// component of the tile's own
+	FTerrainTileMesh& TileMesh = TileMeshes.AddDefaulted_GetRef();
+	if (TileBatchSize > 0)
+	{
+		const double BatchSize = static_cast<double>(TerrainSize) * TileBatchSize;
+		const FIntPoint BatchCoord(FMath::FloorToInt(TileCenter.X / BatchSize), FMath::FloorToInt(TileCenter.Y / BatchSize));
+		FTerrainTileBatch& Batch = TileBatches.FindOrAdd(BatchCoord);
+		if (!Batch.MeshComp)
+		{
+			Batch.MeshComp = CreateTileMeshComp(LOD_Count);
+			Batch.LODCount = LOD_Count;
+		}
+		Batch.TileCount++;
 
-	// Set Material
-	NewMeshComp->SetMaterial(0, TerrainMaterial);
+		// Batches keep the LODs they were set up with
+		TileMesh.MeshComp = Batch.MeshComp;
+		TileMesh.GroupName = FName("Tile", ++NextTileGroupNumber);
+		TileMesh.LODCount = FMath::Min(static_cast<int32>(LOD_Count), Batch.LODCount);
+	}
+	else
+	{
+		TileMesh.MeshComp = CreateTileMeshComp(LOD_Count);
+		TileMesh.GroupName = FName("Mesh");
+		TileMesh.LODCount = LOD_Count;
+	}
+	URealtimeMeshSimple* NRTM = Cast<URealtimeMeshSimple>(TileMesh.MeshComp->GetRealtimeMesh());
+	const FName TileGroupName = TileMesh.GroupName;
+	const int32 TileLODCount = TileMesh.LODCount;
 
 	// Add tile position to built tiles array
 	BuiltTerrainTiles.Add(FVector2D(TileCenter.X, TileCenter.Y));
@@ -382,9 +646,6 @@ void AFastRealtimeEndlessTerrain::GenerateTerrainTile(const FVector TileCenter)
 	const bool bUseNoise = NoiseLayers.Num() > 0;
 	TArray<UFastNoiseWrapper*> NoiseWrappers;
 
-	// LOD Config
-	NRTM->UpdateLODConfig(0, FRealtimeMeshLODConfig(0.9f));
-
 	if (bUseNoise)
 	{
 		UFastNoiseLayeringFunctions::InitNoiseWrappers(this, NoiseWrappers, NoiseLayers, Seed, NoiseScaleOV);
@@ -394,8 +655,16 @@ void AFastRealtimeEndlessTerrain::GenerateTerrainTile(const FVector TileCenter)
 	//FName SectionGroupKeyName = FName(TEXT("Section%i"), TileID);
 	FName SectionGroupKeyName = FName("Mesh");
 
+	// Memory held by every LOD of the tile
+	FTerrainMemoryUsage TileUsage;
+
+	// Stages interleaved within each vert, totalled over every LOD
+	FTerrainStageTimer NoiseTimer;
+	FTerrainStageTimer SmoothingTimer;
+	FTerrainStageTimer NormalsTimer;
+
 	// Generate mesh data per-LOD in a loop
-	for (int32 LODIndex = 0; LODIndex < LOD_Count; LODIndex++)
+	for (int32 LODIndex = 0; LODIndex < TileLODCount; LODIndex++)
 	{
 
 		// Initialize StreamSet. If RealtimeMeshSimple = DynamicMeshComponent, then StreamSet = DynamicMesh object
@@ -417,10 +686,6 @@ void AFastRealtimeEndlessTerrain::GenerateTerrainTile(const FVector TileCenter)
 		TRealtimeMeshStreamBuilder<FColor> ColorBuilder(
 			StreamSet.AddStream(FRealtimeMeshStreams::Color, GetRealtimeMeshBufferLayout<FColor>()));
 
-		// Set up a stream for tris
-		TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>> TrianglesBuilder(
-			StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint16>>()));
-
 		// Set up a stream for polygroups
 		TRealtimeMeshStreamBuilder<uint32, uint16> PolygroupsBuilder(
 		StreamSet.AddStream(FRealtimeMeshStreams::PolyGroups, GetRealtimeMeshBufferLayout<uint16>()));
@@ -433,217 +698,61 @@ void AFastRealtimeEndlessTerrain::GenerateTerrainTile(const FVector TileCenter)
 		const int32 VertReserveCount = (TerrainRes + 1) / ResDivisor;
 		const int32 TriReserveCount = (VertReserveCount - 1);
 
-		// Reserve space in buffers
-		PositionBuilder.Reserve(VertReserveCount);
-		TangentBuilder.Reserve(VertReserveCount);
-		ColorBuilder.Reserve(VertReserveCount);
-		TexCoordsBuilder.Reserve(VertReserveCount);
-		TrianglesBuilder.Reserve(TriReserveCount);
-		PolygroupsBuilder.Reserve(1);
-
-		// Setup LOD if necessary
-		if (LODIndex > 0)
+		// Reserve space in buffers, the counts above are per side so the grid holds their squares, with 2 tris per quad
+		PositionBuilder.Reserve(VertReserveCount * VertReserveCount);
+		TangentBuilder.Reserve(VertReserveCount * VertReserveCount);
+		ColorBuilder.Reserve(VertReserveCount * VertReserveCount);
+		TexCoordsBuilder.Reserve(VertReserveCount * VertReserveCount);
+		PolygroupsBuilder.Reserve(TriReserveCount * TriReserveCount * 2);
+
+		// Set up a stream for tris, 16 bit unless the tile has more verts than 16 bit indices can address
+		TOptional<TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>>> TrianglesBuilder16;
+		TOptional<TRealtimeMeshStreamBuilder<TIndex3<uint32>>> TrianglesBuilder32;
+		if (VertReserveCount * VertReserveCount <= MAX_uint16)
 		{
-			NRTM->AddLOD(FRealtimeMeshLODConfig(FMath::Pow(LOD_DistanceScale, LODIndex)));
+			TrianglesBuilder16.Emplace(StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint16>>()));
+			TrianglesBuilder16->Reserve(TriReserveCount * TriReserveCount * 2);
+		}
+		else
+		{
+			TrianglesBuilder32.Emplace(StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint32>>()));
+			TrianglesBuilder32->Reserve(TriReserveCount * TriReserveCount * 2);
 		}
 
 		// Calculate step size between each vertex
 		float StepSize = TerrainSize / TriReserveCount;// * (LODIndex + (1 + (1 / (2 * (LODIndex + 1)))));
 		if (LODIndex == 0) { StepSize = TerrainSize / TerrainRes; }
 		
-		// Nested XY loop to generate terrain data, store it to the stream sets
-		for (int32 Y = 0; Y < VertReserveCount; Y++)
+		// Generate terrain data into the stream sets, with the kernel for this LOD's features picked once for the whole grid
 		{
-			for (int32 X = 0; X < VertReserveCount; X++)
-			{
-				// Vert positionXY = corner position + step size * vert row & column
-				const FVector2D VertPosXY = FVector2D(ExtentOffsetPosition.X, ExtentOffsetPosition.Y) + FVector2D(StepSize * X, StepSize * Y) + FVector2D(TileCenter.X, TileCenter.Y);
+			TERRAIN_STAGE_SCOPE(StreamBuild);
 
-				//Vert height = 0 by default, optionally offset if noise layers are configured
-				float VertPosZ = 0.0f;
-				if (bUseNoise)
-				{
-					VertPosZ = UFastNoiseLayeringFunctions::BlendNoises
-					(
-						FVector(VertPosXY.X, VertPosXY.Y, 0.0f), FVector(0.0f), NoiseWrappers, NoiseLayers
-					);
-					VertPosZ *= TerrainDepth;
-
-					// If smoothing alpha is not 0, check neighboring vert heights on X+- and Y+- and get the average, then blend the current vert Z w/ the neighboring average using lerp
-					if (SmoothingAlpha > 0 && LODIndex == 0)
-					{
-						// Neighbor X Positive
-						float VertPosZN1 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(VertPosXY.X + (StepSize * SmoothingSteps), VertPosXY.Y, 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN1 *= TerrainDepth;
-
-						// Neighbor X Negative
-						float VertPosZN2 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(VertPosXY.X - (StepSize * SmoothingSteps), VertPosXY.Y, 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN2 *= TerrainDepth;
-
-						// Neighbor Y Positive
-						float VertPosZN3 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(VertPosXY.X, VertPosXY.Y + (StepSize * SmoothingSteps), 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN3 *= TerrainDepth;
-
-						// Neighbor Y Negative
-						float VertPosZN4 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(VertPosXY.X, VertPosXY.Y - (StepSize * SmoothingSteps), 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN4 *= TerrainDepth;
-
-						// Get average of 4 neighbor height checks
-						const float VertPosZNA = (VertPosZN1 + VertPosZN2 + VertPosZN3 + VertPosZN4) / 4;
-
-						// Lerp smoothed height
-						VertPosZ = UKismetMathLibrary::Lerp(VertPosZ, VertPosZNA, SmoothingAlpha);
-					}
-				}
-
-				// Append VertPosZ to VertPosXY for final vert position
-				const FVector3f VertPos = FVector3f(VertPosXY.X, VertPosXY.Y, VertPosZ);
-
-				// Declare VertNormalTangent variable
-				FRealtimeMeshTangentsHighPrecision VertNormalTangent;
-
-				// If no noise, return straight-up facing normals
-				if (!bUseNoise)
-				{
-					const FVector3f VertNormal = FVector3f(0.0f, 0.0f, 1.0f);
-					const FVector3f VertTangent = FVector3f(1.0f, 0.0f, 0.0f);
-					VertNormalTangent = FRealtimeMeshTangentsHighPrecision(VertNormal, VertTangent);
-				}
-
-				// Otherwise, calculate normals & tangents by sampling noise height at neighboring vert positions
-				// While we are taking additional noise lookup costs per-vert, this should allow smooth normals between tile seams
-				else
-				{
-					// Find neighboring XY positions
-					const FVector2D NeighborPosX = FVector2D(VertPos.X, VertPos.Y) + FVector2D(StepSize, 0.0f);
-					const FVector2D NeighborPosY = FVector2D(VertPos.X, VertPos.Y) + FVector2D(0.0f, StepSize);
-
-					// Find height at neighboring XY positions
-					float NeighborHeightX = TerrainDepth * UFastNoiseLayeringFunctions::BlendNoises
-					(
-						FVector(NeighborPosX.X, NeighborPosX.Y, 0.0f),FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-
-					// If smoothing, get smoothed neighbor height
-					if (SmoothingAlpha > 0 && LODIndex == 0)
-					{
-						// Neighbor X Positive
-						float VertPosZN1 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosX.X + (StepSize * SmoothingSteps), NeighborPosX.Y, 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN1 *= TerrainDepth;
-
-						// Neighbor X Negative
-						float VertPosZN2 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosX.X - (StepSize * SmoothingSteps), NeighborPosX.Y, 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN2 *= TerrainDepth;
-
-						// Neighbor Y Positive
-						float VertPosZN3 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosX.X, NeighborPosX.Y + (StepSize * SmoothingSteps), 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN3 *= TerrainDepth;
-
-						// Neighbor Y Negative
-						float VertPosZN4 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosX.X, NeighborPosX.Y - (StepSize * SmoothingSteps), 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN4 *= TerrainDepth;
-
-						// Get average of 4 neighbor height checks
-						const float VertPosZNA = (VertPosZN1 + VertPosZN2 + VertPosZN3 + VertPosZN4) / 4;
-
-						// Lerp smoothed height
-						NeighborHeightX = UKismetMathLibrary::Lerp(NeighborHeightX, VertPosZNA, SmoothingAlpha);
-					}
-
-					// Find height at neighboring XY positions
-					float NeighborHeightY = TerrainDepth * UFastNoiseLayeringFunctions::BlendNoises
-					(
-						FVector(NeighborPosY.X, NeighborPosY.Y, 0.0f), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-
-					// If smoothing, get smoothed neighbor height
-					if (SmoothingAlpha > 0 && LODIndex == 0)
-					{
-						// Neighbor X Positive
-						float VertPosZN1 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosY.X + (StepSize * SmoothingSteps), NeighborPosY.Y, 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN1 *= TerrainDepth;
-
-						// Neighbor X Negative
-						float VertPosZN2 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosY.X - (StepSize * SmoothingSteps), NeighborPosY.Y, 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN2 *= TerrainDepth;
-
-						// Neighbor Y Positive
-						float VertPosZN3 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosY.X, NeighborPosY.Y + (StepSize * SmoothingSteps), 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN3 *= TerrainDepth;
-
-						// Neighbor Y Negative
-						float VertPosZN4 = UFastNoiseLayeringFunctions::BlendNoises
-						(
-							FVector(NeighborPosY.X, NeighborPosY.Y - (StepSize * SmoothingSteps), 0.0f) + GetActorLocation(), FVector(0.0f), NoiseWrappers, NoiseLayers
-						);
-						VertPosZN4 *= TerrainDepth;
-
-						// Get average of 4 neighbor height checks
-						const float VertPosZNA = (VertPosZN1 + VertPosZN2 + VertPosZN3 + VertPosZN4) / 4;
-
-						// Lerp smoothed height
-						NeighborHeightY = UKismetMathLibrary::Lerp(NeighborHeightY, VertPosZNA, SmoothingAlpha);
-					}
-
-					// Calculate tangent vectors with proper grid spacing
-					const FVector3f TangentX = FVector3f(StepSize, 0.0f, NeighborHeightX - VertPosZ).GetUnsafeNormal();
-					const FVector3f TangentY = FVector3f(0.0f, StepSize, NeighborHeightY - VertPosZ).GetUnsafeNormal();
-
-					// Calculate normal from cross product of tangents
-					const FVector3f Normal = FVector3f::CrossProduct(TangentX, TangentY).GetUnsafeNormal();
-
-					// Store tangent & normal to VertNormalTangent
-					VertNormalTangent = FRealtimeMeshTangentsHighPrecision(Normal, TangentX);
-				}
-
-				// Vert color = dummy value for now, maybe tie color to separate noise layer setup for biomes later
-				const FColor VertColor = FColor::Black;
+			FastRealtimeEndlessTerrain::FTileVertKernelParams KernelParams
+			{
+				&NoiseWrappers,
+				&NoiseLayers,
+				FVector2D(ExtentOffsetPosition.X, ExtentOffsetPosition.Y) + FVector2D(TileCenter.X, TileCenter.Y),
+				GetActorLocation(),
+				StepSize,
+				StepSize * SmoothingSteps,
+				SmoothingAlpha,
+				TerrainDepth,
+				VertReserveCount
+			};
+			FastRealtimeEndlessTerrain::FTileVertStreams KernelStreams{ PositionBuilder, TangentBuilder, TexCoordsBuilder, ColorBuilder };
+			FastRealtimeEndlessTerrain::FTileVertTimers KernelTimers{ NoiseTimer, SmoothingTimer, NormalsTimer };
 
-				// Vert UV = XY / TerrainRes
-				const FVector2DHalf VertUV = FVector2DHalf
-				(
-					UKismetMathLibrary::SafeDivide(float(X), float(VertReserveCount - 1)),
-					UKismetMathLibrary::SafeDivide(float(Y), float(VertReserveCount - 1))
-				);
-				
-				// Add this generated data to the stream sets
-				PositionBuilder.Add(VertPos);
-				TangentBuilder.Add(VertNormalTangent);
-				ColorBuilder.Add(VertColor);
-				TexCoordsBuilder.Add(VertUV);
+			if (!bUseNoise)
+			{
+				FastRealtimeEndlessTerrain::BuildTileVerts<false, false>(KernelParams, KernelStreams, KernelTimers);
+			}
+			else if (SmoothingAlpha > 0 && LODIndex == 0)
+			{
+				FastRealtimeEndlessTerrain::BuildTileVerts<true, true>(KernelParams, KernelStreams, KernelTimers);
+			}
+			else
+			{
+				FastRealtimeEndlessTerrain::BuildTileVerts<true, false>(KernelParams, KernelStreams, KernelTimers);
 			}
 		}
 
@@ -651,26 +760,30 @@ void AFastRealtimeEndlessTerrain::GenerateTerrainTile(const FVector TileCenter)
 		//const FVector3f Example = PositionBuilder.Get(0);
 		//UE_LOG(LogTemp, Log, TEXT("Example = %s"), *Example.ToString());
 
-		// Pack tris into RMC format, setup courtesy of Joseph James
-		for (int32 Y = 0; Y < TriReserveCount; Y++)
+		// Pack tris into RMC format at the stream's index width, setup courtesy of Joseph James
 		{
-			for (int32 X = 0; X < TriReserveCount; X++)
-			{
-				// Calculate the index of the bottom left-corner of the current cell
-				const int32 i = (Y * TriReserveCount) + Y + X;
-
-				// First triangle (bottom-left corner of the quad)
-				TrianglesBuilder.Add(TIndex3<uint32>(i, i + TriReserveCount + 1, i + 1));
-				PolygroupsBuilder.Add(0);
+			TERRAIN_STAGE_SCOPE(IndexBuild);
 
-				// Second triangle (top-right corner of the quad)
-				TrianglesBuilder.Add(TIndex3<uint32>(i + 1, i + TriReserveCount + 1, i + TriReserveCount + 2));
-				PolygroupsBuilder.Add(0);
+			if (TrianglesBuilder16.IsSet())
+			{
+				FastRealtimeEndlessTerrain::BuildTileTriangles(*TrianglesBuilder16, PolygroupsBuilder, TriReserveCount);
+			}
+			else
+			{
+				FastRealtimeEndlessTerrain::BuildTileTriangles(*TrianglesBuilder32, PolygroupsBuilder, TriReserveCount);
 			}
 		}
 
+		// Reorder for the vertex cache, if this LOD's grid draw order is ready
+		if (const FTerrainMeshOptimizedOrder* OptimizedOrder = bOptimizeVertexCache ? GetOptimizedGridOrder(TriReserveCount) : nullptr)
+		{
+			FFastRealtimeTerrainMeshOptimizer::ApplyOrder(StreamSet, *OptimizedOrder);
+		}
+
+		TERRAIN_STAGE_SCOPE(SectionCommit);
+
 		// Setup the group key
-		const FRealtimeMeshSectionGroupKey GroupKey = FRealtimeMeshSectionGroupKey::Create(LODIndex, FName("Mesh"));
+		const FRealtimeMeshSectionGroupKey GroupKey = FRealtimeMeshSectionGroupKey::Create(LODIndex, TileGroupName);
 
 		// Setup the section key
 		const FRealtimeMeshSectionKey PolyGroup0SectionKey = FRealtimeMeshSectionKey::CreateForPolyGroup(GroupKey, 0);
@@ -678,10 +791,28 @@ void AFastRealtimeEndlessTerrain::GenerateTerrainTile(const FVector TileCenter)
 		// Now we create the section group
 		NRTM->CreateSectionGroup(GroupKey, StreamSet);
 
-		// Update the configuration of the polygroup section
+		// Update the configuration of the polygroup section, LOD 0 gets handed to the collision cook here
+		TERRAIN_STAGE_SCOPE(CollisionUpdate);
 		NRTM->UpdateSectionConfig(PolyGroup0SectionKey, FRealtimeMeshSectionConfig(0), bDoCollision && LODIndex == 0);
+
+		TileUsage += FTerrainMemoryUsage::ForMeshSection(VertReserveCount * VertReserveCount, TriReserveCount * TriReserveCount * 2, bDoCollision && LODIndex == 0);
+
+		// Each vert blends its own height & its two normal neighbours', & smoothing blends 4 more around each of those
+		TotalVertCount += VertReserveCount * VertReserveCount;
+		if (bUseNoise)
+		{
+			TotalNoiseSampleCount += static_cast<int64>(VertReserveCount * VertReserveCount) * (SmoothingAlpha > 0 && LODIndex == 0 ? 15 : 3);
+		}
 	}
 
+	TileMemoryUsage.Add(TileUsage);
+	MemoryUsage += TileUsage;
+	FTerrainMemoryUsage::UpdatePeak(MemoryUsage, PeakMemoryUsage);
+
+	TERRAIN_STAGE_TIMER_FLUSH(TileNoiseSampling, NoiseTimer);
+	TERRAIN_STAGE_TIMER_FLUSH(TileSmoothing, SmoothingTimer);
+	TERRAIN_STAGE_TIMER_FLUSH(TileNormals, NormalsTimer);
+
 	// Log tile generation time
 	if (bLogTileTimes)
 	{
@@ -708,14 +839,125 @@ void AFastRealtimeEndlessTerrain::ClearTerrain()
 	GetRealtimeMeshComponent()->SetRealtimeMesh(EmptyMesh);
 	PendingTerrainTiles.Empty();
 	BuiltTerrainTiles.Empty();
+	TileMemoryUsage.Empty();
+	TileMeshes.Empty();
+	TileBatches.Empty();
+	FarFieldMeshComp = nullptr;
+	FarFieldHeights.Empty();
+	FarFieldCenterSample.Reset();
+	FarFieldMemoryUsage = FTerrainMemoryUsage();
 	SectionKeys.Empty();
+	MemoryUsage = FTerrainMemoryUsage();
+	PeakMemoryUsage = FTerrainMemoryUsage();
+	TotalVertCount = 0;
+	TotalNoiseSampleCount = 0;
+}
+
+void AFastRealtimeEndlessTerrain::ReportMemoryUsage(FOutputDevice& Ar, bool bDetailed) const
+{
+	MemoryUsage.Report(Ar, FString::Printf(TEXT("%s (%i tiles)"), *GetName(), BuiltTerrainTiles.Num()));
+	PeakMemoryUsage.Report(Ar, FString::Printf(TEXT("%s peak"), *GetName()));
+	if (bDetailed)
+	{
+		for (int32 i = 0; i < TileMemoryUsage.Num(); i++)
+		{
+			TileMemoryUsage[i].Report(Ar, FString::Printf(TEXT("    Tile %s"), *BuiltTerrainTiles[i].ToString()));
+		}
+	}
+}
+
+void AFastRealtimeEndlessTerrain::ApplyQualityLevel(float QualityLevel)
+{
+	if (!bQualityGoverned)
+	{
+		bQualityGoverned = true;
+		UngovernedTileGenDepth = TileGenDepth;
+		UngovernedLODDistanceScale = LOD_DistanceScale;
+	}
+
+	QualityLevel = FMath::Clamp(QualityLevel, 0.0f, 1.0f);
+	TileGenDepth = FMath::RoundToInt(FMath::Lerp(static_cast<float>(MinGovernedTileGenDepth), static_cast<float>(MaxGovernedTileGenDepth), QualityLevel));
+	LOD_DistanceScale = FMath::Lerp(MaxGovernedLODDistanceScale, MinGovernedLODDistanceScale, QualityLevel);
+}
+
+void AFastRealtimeEndlessTerrain::RestoreUngovernedQuality()
+{
+	if (!bQualityGoverned)
+	{
+		return;
+	}
+
+	bQualityGoverned = false;
+	TileGenDepth = UngovernedTileGenDepth;
+	LOD_DistanceScale = UngovernedLODDistanceScale;
+}
+
+void AFastRealtimeEndlessTerrain::StartFlightRecording()
+{
+	FlightRecording.Emplace();
+	FlightRecording->CaptureSettings(this);
+	RecordingFrame = FTerrainFlightPathFrame();
+}
+
+bool AFastRealtimeEndlessTerrain::StopFlightRecording(const FString& FilePath)
+{
+	if (!FlightRecording.IsSet())
+	{
+		return false;
+	}
+
+	const bool bSaved = FlightRecording->SaveToFile(FilePath);
+	FlightRecording.Reset();
+	return bSaved;
+}
+
+bool AFastRealtimeEndlessTerrain::IsGroundBuiltUnder(FVector ObserverLocation) const
+{
+	// Tiles are centered on their build positions, which aren't always on the snapping grid
+	const float TileHalfSize = TerrainSize * 0.5f;
+	for (const FVector2D& TileCenter : BuiltTerrainTiles)
+	{
+		if (FMath::Abs(ObserverLocation.X - TileCenter.X) <= TileHalfSize && FMath::Abs(ObserverLocation.Y - TileCenter.Y) <= TileHalfSize)
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 void AFastRealtimeEndlessTerrain::UpdateObserverPosition(FVector ObserverLocation)
 {
+	if (FlightRecording.IsSet())
+	{
+		RecordingFrame.bObserverUpdated = true;
+		RecordingFrame.ObserverLocation = ObserverLocation;
+	}
+	LastObserverLocation = ObserverLocation;
+
 	// Snap position to discreet tile grid
 	const FVector2D SnappedObserverLocation = SnapPositionToGrid(ObserverLocation);
 
+	// Remove built & pending tiles that have fallen outside the eviction square around the observer, never evicting any tile
+	// this update would queue again
+	if (TileEvictionDepth > 0)
+	{
+		const float EvictionHalfExtent = (FMath::Max(TileEvictionDepth, TileGenDepth) - 1) * 0.5f * TerrainSize;
+		auto IsOutsideEviction = [&](const FVector2D& TileCenter)
+		{
+			const FVector2D Offset = (TileCenter - SnappedObserverLocation).GetAbs();
+			return FMath::Max(Offset.X, Offset.Y) > EvictionHalfExtent + (TerrainSize * 0.01f);
+		};
+
+		for (int32 i = BuiltTerrainTiles.Num() - 1; i >= 0; i--)
+		{
+			if (IsOutsideEviction(BuiltTerrainTiles[i]))
+			{
+				RemoveTerrainTile(i);
+			}
+		}
+		PendingTerrainTiles.RemoveAll(IsOutsideEviction);
+	}
+
 	// Calculate starting tile range evaluation position
 	const FVector2D StartingOffset = SnappedObserverLocation - FVector2D((TerrainSize * 0.5f) * (TileGenDepth - 1), (TerrainSize * 0.5f) * (TileGenDepth - 1));
 
@@ -735,6 +977,337 @@ void AFastRealtimeEndlessTerrain::UpdateObserverPosition(FVector ObserverLocatio
 			}
 		}
 	}
+
+	if (bBuildFarField)
+	{
+		UpdateFarField(SnappedObserverLocation);
+	}
+}
+
+void AFastRealtimeEndlessTerrain::UpdateFarField(const FVector2D& SnappedObserverLocation)
+{
+	// Far-field samples sit on a world aligned grid, so samples carry over between updates as the observer moves
+	const int32 SamplesPerTile = FMath::Max(FarFieldRes, 1);
+	const float Spacing = TerrainSize / SamplesPerTile;
+	const FIntPoint CenterSample(FMath::RoundToInt(SnappedObserverLocation.X / Spacing), FMath::RoundToInt(SnappedObserverLocation.Y / Spacing));
+	if (FarFieldCenterSample.IsSet() && FarFieldCenterSample.GetValue() == CenterSample)
+	{
+		return;
+	}
+	FarFieldCenterSample = CenterSample;
+
+	TERRAIN_STAGE_SCOPE(FarFieldBuild);
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
+	// The ring runs from one tile inside the edge of the streamed tiles out to FarFieldDepth, the overlap is where it fades out
+	const float TileHalfExtent = TileGenDepth * TerrainSize * 0.5f;
+	const float HoleHalfExtent = FMath::Max(TileHalfExtent - TerrainSize, 0.0f);
+	const int32 HalfSamples = FMath::CeilToInt(FMath::Max(FarFieldDepth, static_cast<uint8>(TileGenDepth + 1)) * SamplesPerTile * 0.5f);
+	const int32 SampleSide = (HalfSamples * 2) + 1;
+
+	// Forget heights that have fallen out of the ring & the apron of samples its normals read from
+	for (TMap<FIntPoint, float>::TIterator It = FarFieldHeights.CreateIterator(); It; ++It)
+	{
+		if (FMath::Abs(It->Key.X - CenterSample.X) > HalfSamples + 1 || FMath::Abs(It->Key.Y - CenterSample.Y) > HalfSamples + 1)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Only samples new to the ring hit the noise, using the same base height the tiles are displaced by
+	const bool bUseNoise = NoiseLayers.Num() > 0;
+	TArray<UFastNoiseWrapper*> NoiseWrappers;
+	auto GetHeight = [&](int32 X, int32 Y)
+	{
+		const FIntPoint Sample = CenterSample + FIntPoint(X, Y);
+		if (const float* Height = FarFieldHeights.Find(Sample))
+		{
+			return *Height;
+		}
+
+		float Height = 0.0f;
+		if (bUseNoise)
+		{
+			if (NoiseWrappers.Num() == 0)
+			{
+				UFastNoiseLayeringFunctions::InitNoiseWrappers(this, NoiseWrappers, NoiseLayers, Seed, NoiseScaleOV);
+			}
+			Height = UFastNoiseLayeringFunctions::BlendNoises(FVector(Sample.X * Spacing, Sample.Y * Spacing, 0.0f), FVector(0.0f), NoiseWrappers, NoiseLayers) * TerrainDepth;
+		}
+		return FarFieldHeights.Add(Sample, Height);
+	};
+
+	// Quads entirely inside the hole are left out, along with any verts only they use
+	auto IsQuadInHole = [&](int32 X, int32 Y)
+	{
+		return FMath::Max(FMath::Abs(X), FMath::Abs(X + 1)) * Spacing <= HoleHalfExtent + (Spacing * 0.01f)
+			&& FMath::Max(FMath::Abs(Y), FMath::Abs(Y + 1)) * Spacing <= HoleHalfExtent + (Spacing * 0.01f);
+	};
+	TArray<int32> VertIndices;
+	VertIndices.Init(INDEX_NONE, SampleSide * SampleSide);
+	auto GetVertSlot = [&](int32 X, int32 Y) -> int32& { return VertIndices[(X + HalfSamples) + ((Y + HalfSamples) * SampleSide)]; };
+	TArray<FIntPoint> VertSamples;
+	int32 QuadCount = 0;
+	for (int32 Y = -HalfSamples; Y < HalfSamples; Y++)
+	{
+		for (int32 X = -HalfSamples; X < HalfSamples; X++)
+		{
+			if (IsQuadInHole(X, Y))
+			{
+				continue;
+			}
+			QuadCount++;
+			for (const FIntPoint& Corner : { FIntPoint(X, Y), FIntPoint(X + 1, Y), FIntPoint(X, Y + 1), FIntPoint(X + 1, Y + 1) })
+			{
+				int32& Slot = GetVertSlot(Corner.X, Corner.Y);
+				if (Slot == INDEX_NONE)
+				{
+					Slot = VertSamples.Add(Corner);
+				}
+			}
+		}
+	}
+
+	// Initialize StreamSet
+	FRealtimeMeshStreamSet StreamSet;
+
+	// Set up a stream for vertex positions
+	TRealtimeMeshStreamBuilder<FVector3f> PositionBuilder(
+		StreamSet.AddStream(FRealtimeMeshStreams::Position, GetRealtimeMeshBufferLayout<FVector3f>()));
+
+	// Set up a stream for tangents
+	TRealtimeMeshStreamBuilder<FRealtimeMeshTangentsHighPrecision, FRealtimeMeshTangentsNormalPrecision> TangentBuilder(
+		StreamSet.AddStream(FRealtimeMeshStreams::Tangents, GetRealtimeMeshBufferLayout<FRealtimeMeshTangentsNormalPrecision>()));
+
+	// Set up a stream for texcoords
+	TRealtimeMeshStreamBuilder<FVector2f, FVector2DHalf> TexCoordsBuilder(
+		StreamSet.AddStream(FRealtimeMeshStreams::TexCoords, GetRealtimeMeshBufferLayout<FVector2DHalf>()));
+
+	// Set up a stream for vertex colors
+	TRealtimeMeshStreamBuilder<FColor> ColorBuilder(
+		StreamSet.AddStream(FRealtimeMeshStreams::Color, GetRealtimeMeshBufferLayout<FColor>()));
+
+	// Set up a stream for polygroups
+	TRealtimeMeshStreamBuilder<uint32, uint16> PolygroupsBuilder(
+		StreamSet.AddStream(FRealtimeMeshStreams::PolyGroups, GetRealtimeMeshBufferLayout<uint16>()));
+
+	// Set up a stream for tris, always 32 bit as large rings can pass what 16 bit indices can address
+	TRealtimeMeshStreamBuilder<TIndex3<uint32>> TrianglesBuilder(
+		StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint32>>()));
+
+	PositionBuilder.Reserve(VertSamples.Num());
+	TangentBuilder.Reserve(VertSamples.Num());
+	TexCoordsBuilder.Reserve(VertSamples.Num());
+	ColorBuilder.Reserve(VertSamples.Num());
+	PolygroupsBuilder.Reserve(QuadCount * 2);
+	TrianglesBuilder.Reserve(QuadCount * 2);
+
+	// Fraction of FarFieldSinkDepth the far field stays sunk by all the way out to the edge of the tiles, so it never meets them
+	const float MinSinkFraction = 0.25f;
+
+	// Fill every used vert, fading from fully sunk & transparent at the hole's edge to opaque at the edge of the tiles. Verts
+	// under the tiles stay sunk by at least MinSinkFraction, only verts past the tiles sit at full height
+	for (const FIntPoint& VertSample : VertSamples)
+	{
+		const int32 X = VertSample.X;
+		const int32 Y = VertSample.Y;
+		const float Distance = FMath::Max(FMath::Abs(X), FMath::Abs(Y)) * Spacing;
+		const float Fade = TileHalfExtent > HoleHalfExtent ? FMath::SmoothStep(HoleHalfExtent, TileHalfExtent, Distance) : 1.0f;
+		const float SinkFraction = Distance <= TileHalfExtent + (Spacing * 0.01f) ? FMath::Lerp(1.0f, MinSinkFraction, Fade) : 0.0f;
+
+		const float Height = GetHeight(X, Y);
+		const FVector3f VertPos(
+			(CenterSample.X + X) * Spacing,
+			(CenterSample.Y + Y) * Spacing,
+			Height - (FarFieldSinkDepth * SinkFraction));
+
+		// Normal from the heights either side, the same way the tiles take theirs
+		const FVector3f TangentX = FVector3f(Spacing * 2.0f, 0.0f, GetHeight(X + 1, Y) - GetHeight(X - 1, Y)).GetSafeNormal();
+		const FVector3f TangentY = FVector3f(0.0f, Spacing * 2.0f, GetHeight(X, Y + 1) - GetHeight(X, Y - 1)).GetSafeNormal();
+		const FVector3f Normal = FVector3f::CrossProduct(TangentX, TangentY).GetSafeNormal();
+
+		PositionBuilder.Add(VertPos);
+		TangentBuilder.Add(FRealtimeMeshTangentsHighPrecision(Normal, TangentX));
+		TexCoordsBuilder.Add(FVector2f(VertPos.X / TerrainSize, VertPos.Y / TerrainSize));
+		ColorBuilder.Add(FColor(0, 0, 0, static_cast<uint8>(FMath::RoundToInt(Fade * 255.0f))));
+	}
+
+	// Same winding as the tiles
+	for (int32 Y = -HalfSamples; Y < HalfSamples; Y++)
+	{
+		for (int32 X = -HalfSamples; X < HalfSamples; X++)
+		{
+			if (IsQuadInHole(X, Y))
+			{
+				continue;
+			}
+			const uint32 V00 = GetVertSlot(X, Y);
+			const uint32 V10 = GetVertSlot(X + 1, Y);
+			const uint32 V01 = GetVertSlot(X, Y + 1);
+			const uint32 V11 = GetVertSlot(X + 1, Y + 1);
+			TrianglesBuilder.Add(TIndex3<uint32>(V00, V01, V10));
+			PolygroupsBuilder.Add(0);
+			TrianglesBuilder.Add(TIndex3<uint32>(V10, V01, V11));
+			PolygroupsBuilder.Add(0);
+		}
+	}
+
+	// Create the far field's component the first time round, it never collides
+	const FRealtimeMeshSectionGroupKey GroupKey = FRealtimeMeshSectionGroupKey::Create(0, FName("FarField"));
+	if (!FarFieldMeshComp)
+	{
+		FarFieldMeshComp = CreateTileMeshComp(1);
+		FarFieldMeshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		FarFieldMeshComp->SetMaterial(0, FarFieldMaterial ? FarFieldMaterial : TerrainMaterial);
+
+		URealtimeMeshSimple* FarFieldRTM = Cast<URealtimeMeshSimple>(FarFieldMeshComp->GetRealtimeMesh());
+		FarFieldRTM->CreateSectionGroup(GroupKey, StreamSet);
+		FarFieldRTM->UpdateSectionConfig(FRealtimeMeshSectionKey::CreateForPolyGroup(GroupKey, 0), FRealtimeMeshSectionConfig(0), false);
+	}
+	else
+	{
+		Cast<URealtimeMeshSimple>(FarFieldMeshComp->GetRealtimeMesh())->UpdateSectionGroup(GroupKey, StreamSet);
+	}
+
+	// Swap the old ring's memory for the new one's
+	MemoryUsage -= FarFieldMemoryUsage;
+	FarFieldMemoryUsage = FTerrainMemoryUsage::ForMeshSection(VertSamples.Num(), QuadCount * 2, false);
+	MemoryUsage += FarFieldMemoryUsage;
+	FTerrainMemoryUsage::UpdatePeak(MemoryUsage, PeakMemoryUsage);
+}
+
+URealtimeMeshComponent* AFastRealtimeEndlessTerrain::CreateTileMeshComp(int32 LODCount)
+{
+	// Initialize a new RuntimeMeshComponent
+	URealtimeMeshComponent* NewMeshComp = NewObject<URealtimeMeshComponent>(this, URealtimeMeshComponent::StaticClass());
+	NewMeshComp->RegisterComponent();
+	NewMeshComp->SetCollisionProfileName("BlockAll");
+	GeneratedMeshComps.Add(NewMeshComp);
+	
+	// Initialize Realtime Mesh Simple
+	URealtimeMeshSimple* NRTM = NewMeshComp->InitializeRealtimeMesh<URealtimeMeshSimple>();
+
+	// Set collision settings
+	FRealtimeMeshCollisionConfiguration CollisionConfig = FRealtimeMeshCollisionConfiguration();
+	CollisionConfig.bUseAsyncCook = true;
+	CollisionConfig.bDeformableMesh = false;
+	CollisionConfig.bUseComplexAsSimpleCollision = true;
+	CollisionConfig.bMergeAllMeshes = true;
+	NRTM->SetCollisionConfig(CollisionConfig);
+		
+	// Setup the material slot
+	NRTM->SetupMaterialSlot(0, TEXT("TerrainMaterial"));
+
+	// Set Material
+	NewMeshComp->SetMaterial(0, TerrainMaterial);
+
+	// LOD Config
+	NRTM->UpdateLODConfig(0, FRealtimeMeshLODConfig(0.9f));
+	for (int32 LODIndex = 1; LODIndex < LODCount; LODIndex++)
+	{
+		NRTM->AddLOD(FRealtimeMeshLODConfig(FMath::Pow(LOD_DistanceScale, LODIndex)));
+	}
+
+	return NewMeshComp;
+}
+
+void AFastRealtimeEndlessTerrain::RemoveTerrainTile(int32 TileIndex)
+{
+	const FTerrainTileMesh TileMesh = TileMeshes[TileIndex];
+
+	// Batched tiles only take their own section groups with them, unless they were the last tile in their batch
+	bool bDestroyMeshComp = true;
+	for (TMap<FIntPoint, FTerrainTileBatch>::TIterator It = TileBatches.CreateIterator(); It; ++It)
+	{
+		if (It->Value.MeshComp == TileMesh.MeshComp)
+		{
+			bDestroyMeshComp = --It->Value.TileCount <= 0;
+			if (bDestroyMeshComp)
+			{
+				It.RemoveCurrent();
+			}
+			break;
+		}
+	}
+
+	if (bDestroyMeshComp)
+	{
+		URealtimeMesh* EmptyMesh = nullptr;
+		TileMesh.MeshComp->SetRealtimeMesh(EmptyMesh);
+		TileMesh.MeshComp->DestroyComponent();
+		GeneratedMeshComps.Remove(TileMesh.MeshComp);
+	}
+	else if (URealtimeMeshSimple* BatchRTM = Cast<URealtimeMeshSimple>(TileMesh.MeshComp->GetRealtimeMesh()))
+	{
+		for (int32 LODIndex = 0; LODIndex < TileMesh.LODCount; LODIndex++)
+		{
+			BatchRTM->RemoveSectionGroup(FRealtimeMeshSectionGroupKey::Create(LODIndex, TileMesh.GroupName));
+		}
+	}
+
+	// Every per-tile array is indexed the same, so they're all removed from the same way
+	MemoryUsage -= TileMemoryUsage[TileIndex];
+	BuiltTerrainTiles.RemoveAtSwap(TileIndex);
+	TileMemoryUsage.RemoveAtSwap(TileIndex);
+	TileMeshes.RemoveAtSwap(TileIndex);
+}
+
+void AFastRealtimeEndlessTerrain::PrepareOptimizedGridOrders(bool bWait)
+{
+	if (!bOptimizeVertexCache)
+	{
+		return;
+	}
+
+	for (int32 LODIndex = 0; LODIndex < LOD_Count; LODIndex++)
+	{
+		const int32 ResDivisor = LODIndex == 0 ? 1 : LODIndex + LOD_Breakdown_Count;
+		const int32 QuadRes = ((TerrainRes + 1) / ResDivisor) - 1;
+		GetOptimizedGridOrder(QuadRes);
+		if (bWait)
+		{
+			if (UE::Tasks::TTask<FTerrainMeshOptimizedOrder>* Task = OptimizedGridOrders.Find(QuadRes))
+			{
+				Task->Wait();
+			}
+		}
+	}
+}
+
+const FTerrainMeshOptimizedOrder* AFastRealtimeEndlessTerrain::GetOptimizedGridOrder(int32 QuadRes)
+{
+	if (QuadRes <= 0)
+	{
+		return nullptr;
+	}
+
+	UE::Tasks::TTask<FTerrainMeshOptimizedOrder>* Task = OptimizedGridOrders.Find(QuadRes);
+	if (!Task)
+	{
+		Task = &OptimizedGridOrders.Add(QuadRes, UE::Tasks::Launch(UE_SOURCE_LOCATION, [QuadRes]()
+		{
+			LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
+			// Same triangles the tile index loops emit
+			const int32 VertRes = QuadRes + 1;
+			TArray<uint32> Indices;
+			Indices.Reserve(QuadRes * QuadRes * 6);
+			for (int32 Y = 0; Y < QuadRes; Y++)
+			{
+				for (int32 X = 0; X < QuadRes; X++)
+				{
+					const uint32 i = (Y * VertRes) + X;
+					Indices.Append({ i, i + VertRes, i + 1 });
+					Indices.Append({ i + 1, i + VertRes, i + VertRes + 1 });
+				}
+			}
+
+			FTerrainMeshOptimizedOrder Order;
+			FFastRealtimeTerrainMeshOptimizer::Optimize(Indices, VertRes * VertRes, Order);
+			return Order;
+		}));
+	}
+	return Task->IsCompleted() ? &Task->GetResult() : nullptr;
 }
 
 FVector2D AFastRealtimeEndlessTerrain::SnapPositionToGrid(FVector DiscreetPosition) const
@@ -0,0 +1,801 @@
+
+
+
+#include "FastRealtimeMarchingCubeMesher.h"
+#include "FastRealtimeMarchingCubePlanet.h"
+#include "FastRealtimePlanetScalarField.h"
+#include "FastRealtimeTerrainMeshOptimizer.h"
+#include "FastRealtimeTerrainStats.h"
+
+namespace FastRealtimeMarchingCubeMesher
+{
+	// Sample offsets from a cube's min corner out to each of its verts, ordered to match AFastRealtimeMarchingCubePlanet::VertexDirections
+	static const FIntVector VertexSampleOffsets[8] =
+	{
+		FIntVector(1, 1, 1),
+		FIntVector(0, 1, 1),
+		FIntVector(0, 0, 1),
+		FIntVector(1, 0, 1),
+		FIntVector(1, 1, 0),
+		FIntVector(0, 1, 0),
+		FIntVector(0, 0, 0),
+		FIntVector(1, 0, 0)
+	};
+
+	// Packs 8 bytes into a word, byte i into bits 8i to 8i + 7
+	static uint64 LoadWord(const uint8* Bytes)
+	{
+		uint64 Word = 0;
+		for (int32 i = 0; i < 8; i++)
+		{
+			Word |= static_cast<uint64>(Bytes[i]) << (i * 8);
+		}
+		return Word;
+	}
+
+	// Case indices of 8 neighbouring cubes along X, one per byte, starting at cube X of a row. SampleRows are the density grid
+	// rows at (Y, Z), (Y + 1, Z), (Y, Z + 1) & (Y + 1, Z + 1). A quantized sample is at or above the iso level exactly when
+	// its top bit is set, so each row word is reduced to a 0 or 1 per byte & shifted into its corner's bit of the case, so
+	// every word op classifies 8 cubes on any platform without needing vector intrinsics
+	static uint64 ClassifyCubes(const uint8* const (&SampleRows)[4], int32 X)
+	{
+		constexpr uint64 ByteLowBits = 0x0101010101010101ull;
+		uint64 Outside[4][2];
+		for (int32 Row = 0; Row < 4; Row++)
+		{
+			Outside[Row][0] = (LoadWord(SampleRows[Row] + X) >> 7) & ByteLowBits;
+			Outside[Row][1] = (LoadWord(SampleRows[Row] + X + 1) >> 7) & ByteLowBits;
+		}
+
+		// Corner i sits on row (Y offset + 2 * Z offset) of VertexSampleOffsets[i], at its X offset
+		uint64 Cases = 0;
+		for (int32 i = 0; i < 8; i++)
+		{
+			const FIntVector& Offset = VertexSampleOffsets[i];
+			Cases |= Outside[Offset.Y + (Offset.Z * 2)][Offset.X] << i;
+		}
+		return Cases;
+	}
+
+	// Reads a chunk-local sample from a build's snapshot
+	static float GetSnapshotSample(const FPlanetChunkBuildInput& Input, const FIntVector& Sample)
+	{
+		const FIntVector Local = Sample - Input.SnapshotOrigin;
+		return Input.Samples[Local.X + (Local.Y * Input.SnapshotRes.X) + (Local.Z * Input.SnapshotRes.X * Input.SnapshotRes.Y)];
+	}
+
+	// Field gradient at a chunk-local sample by central differences. Values rise from solid to empty, so it points out of the
+	// surface. Left unscaled as it's only ever normalized
+	static FVector3f GetSampleGradient(const FPlanetChunkBuildInput& Input, const FIntVector& Sample)
+	{
+		return FVector3f(
+			GetSnapshotSample(Input, Sample + FIntVector(1, 0, 0)) - GetSnapshotSample(Input, Sample - FIntVector(1, 0, 0)),
+			GetSnapshotSample(Input, Sample + FIntVector(0, 1, 0)) - GetSnapshotSample(Input, Sample - FIntVector(0, 1, 0)),
+			GetSnapshotSample(Input, Sample + FIntVector(0, 0, 1)) - GetSnapshotSample(Input, Sample - FIntVector(0, 0, 1)));
+	}
+
+	// Gradients at a cube's 8 corners, corner i is offset by its X, Y & Z bits
+	static void GetCornerGradients(const FPlanetChunkBuildInput& Input, const FIntVector& Cube, FVector3f (&OutGradients)[8])
+	{
+		for (int32 i = 0; i < 8; i++)
+		{
+			OutGradients[i] = GetSampleGradient(Input, Cube + FIntVector(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+		}
+	}
+
+	// Trilinearly blends corner gradients to a point T within the cube, in 0 - 1 from its min corner
+	static FVector3f BlendGradients(const FVector3f (&Gradients)[8], const FVector3f& T)
+	{
+		const FVector3f X00 = FMath::Lerp(Gradients[0], Gradients[1], T.X);
+		const FVector3f X10 = FMath::Lerp(Gradients[2], Gradients[3], T.X);
+		const FVector3f X01 = FMath::Lerp(Gradients[4], Gradients[5], T.X);
+		const FVector3f X11 = FMath::Lerp(Gradients[6], Gradients[7], T.X);
+		return FMath::Lerp(FMath::Lerp(X00, X10, T.Y), FMath::Lerp(X01, X11, T.Y), T.Z);
+	}
+
+	// Builds a tangent frame around a gradient normal, keeping the tangent as close to Hint as it can. Falls back to the
+	// hint frame where the gradient cancels out
+	static FRealtimeMeshTangentsHighPrecision MakeGradientTangents(const FVector3f& Gradient, const FVector3f& HintNormal, const FVector3f& HintTangent)
+	{
+		const FVector3f Normal = Gradient.GetSafeNormal();
+		if (Normal.IsNearlyZero())
+		{
+			return FRealtimeMeshTangentsHighPrecision(HintNormal, HintTangent);
+		}
+		FVector3f TangentX = (HintTangent - (Normal * FVector3f::DotProduct(Normal, HintTangent))).GetSafeNormal();
+		if (TangentX.IsNearlyZero())
+		{
+			TangentX = FVector3f::CrossProduct(Normal, FMath::Abs(Normal.Z) < 0.99f ? FVector3f::UpVector : FVector3f::ForwardVector).GetSafeNormal();
+		}
+		return FRealtimeMeshTangentsHighPrecision(Normal, TangentX);
+	}
+}
+
+struct FFastRealtimeMarchingCubeMesher::FSectionBuilders
+{
+	TRealtimeMeshStreamBuilder<FVector3f> Position;
+	TRealtimeMeshStreamBuilder<FRealtimeMeshTangentsHighPrecision, FRealtimeMeshTangentsNormalPrecision> Tangents;
+	TRealtimeMeshStreamBuilder<FVector2f, FVector2DHalf> TexCoords;
+	TRealtimeMeshStreamBuilder<FColor> Color;
+	TRealtimeMeshStreamBuilder<uint32, uint16> Polygroups;
+
+	// Only one of these is set, 16 bit unless the section has more verts than 16 bit indices can address
+	TUniquePtr<TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>>> Triangles16;
+	TUniquePtr<TRealtimeMeshStreamBuilder<TIndex3<uint32>>> Triangles32;
+
+	// Sets up every stream, allocated at its final size up front so filling them never reallocates
+	FSectionBuilders(FRealtimeMeshStreamSet& StreamSet, int32 VertexCount, int32 TriangleCount)
+		// Set up a stream for vertex positions
+		: Position(StreamSet.AddStream(FRealtimeMeshStreams::Position, GetRealtimeMeshBufferLayout<FVector3f>()))
+		// Set up a stream for tangents
+		, Tangents(StreamSet.AddStream(FRealtimeMeshStreams::Tangents, GetRealtimeMeshBufferLayout<FRealtimeMeshTangentsNormalPrecision>()))
+		// Set up a stream for texcoords
+		, TexCoords(StreamSet.AddStream(FRealtimeMeshStreams::TexCoords, GetRealtimeMeshBufferLayout<FVector2DHalf>()))
+		// Set up a stream for vertex colors
+		, Color(StreamSet.AddStream(FRealtimeMeshStreams::Color, GetRealtimeMeshBufferLayout<FColor>()))
+		// Set up a stream for polygroups
+		, Polygroups(StreamSet.AddStream(FRealtimeMeshStreams::PolyGroups, GetRealtimeMeshBufferLayout<uint16>()))
+	{
+		// Set up a stream for tris, as narrow as the section's vert count allows
+		if (Uses16BitIndices(VertexCount))
+		{
+			Triangles16 = MakeUnique<TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>>>(
+				StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint16>>()));
+			Triangles16->Reserve(TriangleCount);
+		}
+		else
+		{
+			Triangles32 = MakeUnique<TRealtimeMeshStreamBuilder<TIndex3<uint32>>>(
+				StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint32>>()));
+			Triangles32->Reserve(TriangleCount);
+		}
+
+		Position.Reserve(VertexCount);
+		Tangents.Reserve(VertexCount);
+		TexCoords.Reserve(VertexCount);
+		Color.Reserve(VertexCount);
+		Polygroups.Reserve(TriangleCount);
+	}
+
+	void AddTriangle(const TIndex3<uint32>& Triangle)
+	{
+		if (Triangles16)
+		{
+			Triangles16->Add(Triangle);
+		}
+		else
+		{
+			Triangles32->Add(Triangle);
+		}
+		Polygroups.Add(0);
+	}
+
+	TIndex3<uint32> GetTriangle(int32 Index) const { return Triangles16 ? Triangles16->Get(Index) : Triangles32->Get(Index); }
+	int32 NumTriangles() const { return Triangles16 ? Triangles16->Num() : Triangles32->Num(); }
+};
+
+void FFastRealtimeMarchingCubeMesher::ApplyEditOps(FPlanetChunkBuildInput& Input)
+{
+	if (Input.EditOps.Num() == 0 || Input.Samples.Num() == 0)
+	{
+		return;
+	}
+
+	TERRAIN_STAGE_SCOPE(EditApply);
+
+	const FIntVector SnapshotMax = Input.SnapshotRes - FIntVector(1);
+	for (const FPlanetEditOp& Op : Input.EditOps)
+	{
+		// An op can still pull samples up to one field step outside its bounds across the iso level, so reach that far too
+		const FBox3f Bounds = Op.GetBounds().ExpandBy(Input.FieldSampleStep);
+		const FVector3f MinPosition = (((Bounds.Min - Input.FieldOrigin) / Input.FieldSampleStep) - FVector3f(Input.FieldSampleOrigin)) / Input.FieldSampleStride;
+		const FVector3f MaxPosition = (((Bounds.Max - Input.FieldOrigin) / Input.FieldSampleStep) - FVector3f(Input.FieldSampleOrigin)) / Input.FieldSampleStride;
+
+		// Snapshot sample range the op reaches, skipping ops that miss the snapshot entirely
+		const FIntVector MinLocal = FIntVector(
+			FMath::Max(FMath::FloorToInt32(MinPosition.X) - Input.SnapshotOrigin.X, 0),
+			FMath::Max(FMath::FloorToInt32(MinPosition.Y) - Input.SnapshotOrigin.Y, 0),
+			FMath::Max(FMath::FloorToInt32(MinPosition.Z) - Input.SnapshotOrigin.Z, 0));
+		const FIntVector MaxLocal = FIntVector(
+			FMath::Min(FMath::CeilToInt32(MaxPosition.X) - Input.SnapshotOrigin.X, SnapshotMax.X),
+			FMath::Min(FMath::CeilToInt32(MaxPosition.Y) - Input.SnapshotOrigin.Y, SnapshotMax.Y),
+			FMath::Min(FMath::CeilToInt32(MaxPosition.Z) - Input.SnapshotOrigin.Z, SnapshotMax.Z));
+		if (MinLocal.X > MaxLocal.X || MinLocal.Y > MaxLocal.Y || MinLocal.Z > MaxLocal.Z)
+		{
+			continue;
+		}
+
+		// Ops are applied one after the other, so every sample still sees them in the order they were made
+		for (int32 Z = MinLocal.Z; Z <= MaxLocal.Z; Z++)
+		{
+			for (int32 Y = MinLocal.Y; Y <= MaxLocal.Y; Y++)
+			{
+				int32 SampleIndex = MinLocal.X + (Y * Input.SnapshotRes.X) + (Z * Input.SnapshotRes.X * Input.SnapshotRes.Y);
+				for (int32 X = MinLocal.X; X <= MaxLocal.X; X++, SampleIndex++)
+				{
+					const FIntVector S = Input.FieldSampleOrigin + (Input.SnapshotOrigin + FIntVector(X, Y, Z)) * Input.FieldSampleStride;
+					const FVector3f SamplePosition = Input.FieldOrigin + FVector3f(S) * Input.FieldSampleStep;
+					Input.Samples[SampleIndex] = Op.Apply(Input.Samples[SampleIndex], SamplePosition, Input.FieldSampleStep);
+				}
+			}
+		}
+	}
+}
+
+void FFastRealtimeMarchingCubeMesher::BuildChunk(const FPlanetChunkBuildInput& Input, FPlanetChunkBuildResult& Result)
+{
+	TERRAIN_STAGE_SCOPE(ChunkBuild);
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
+	Result.MeshComp = Input.MeshComp;
+	Result.ChunkKey = Input.ChunkKey;
+	Result.BuildSerial = Input.BuildSerial;
+	Result.bUpdate = Input.bUpdate;
+	Result.bAllSections = Input.SectionBricks.Num() == 0;
+	Result.MaxTri = 0;
+
+	// Bail if there's nothing to look triangulation data up from
+	if (Input.CubeCount <= 0 || (Input.MesherType == EPlanetMesherType::MarchingCubes && !Input.TriangulationTable.IsValid()))
+	{
+		return;
+	}
+
+	const int32 SectionSize = Input.SectionSize > 0 ? Input.SectionSize : Input.CubeCount;
+	const int32 SectionRes = GetSectionRes(Input.CubeCount, Input.SectionSize);
+
+	// Marching cubes classifies from an 8-bit copy of the snapshot, padded so whole words can be read off the end of any row
+	TArray<uint8> Density;
+	if (Input.MesherType == EPlanetMesherType::MarchingCubes)
+	{
+		Density.SetNumUninitialized(Input.Samples.Num() + sizeof(uint64));
+		for (int32 i = 0; i < Input.Samples.Num(); i++)
+		{
+			Density[i] = FPlanetScalarField::QuantizeValue(Input.Samples[i]);
+		}
+		FMemory::Memzero(&Density[Input.Samples.Num()], sizeof(uint64));
+	}
+
+	// Gather the section bricks to build
+	TArray<FIntVector> SectionBricks = Input.SectionBricks;
+	if (SectionBricks.Num() == 0)
+	{
+		for (int32 Z = 0; Z < SectionRes; Z++)
+		{
+			for (int32 Y = 0; Y < SectionRes; Y++)
+			{
+				for (int32 X = 0; X < SectionRes; X++)
+				{
+					SectionBricks.Add(FIntVector(X, Y, Z));
+				}
+			}
+		}
+	}
+
+	for (const FIntVector& SectionBrick : SectionBricks)
+	{
+		FPlanetChunkSectionResult& Section = Result.Sections.AddDefaulted_GetRef();
+		Section.SectionIndex = SectionBrick.X + (SectionBrick.Y * SectionRes) + (SectionBrick.Z * SectionRes * SectionRes);
+
+		// Cube range covered by this section brick, the last brick along each axis may be partial
+		const FIntVector CubeMin = SectionBrick * SectionSize;
+		const FIntVector CubeMax = FIntVector(
+			FMath::Min(CubeMin.X + SectionSize, Input.CubeCount),
+			FMath::Min(CubeMin.Y + SectionSize, Input.CubeCount),
+			FMath::Min(CubeMin.Z + SectionSize, Input.CubeCount));
+
+		Section.MaxTri = Input.MesherType == EPlanetMesherType::SurfaceNets
+			? BuildSurfaceNetsSection(Input, CubeMin, CubeMax, Section)
+			: BuildMarchingCubesSection(Input, Density, CubeMin, CubeMax, Section);
+		Result.MaxTri += Section.MaxTri;
+
+		if (Input.bOptimizeVertexCache && Section.TriangleCount > 0)
+		{
+			FFastRealtimeTerrainMeshOptimizer::OptimizeStreamSet(Section.StreamSet);
+		}
+	}
+}
+
+int32 FFastRealtimeMarchingCubeMesher::BuildMarchingCubesSection(const FPlanetChunkBuildInput& Input, const TArray<uint8>& Density, const FIntVector& CubeMin, const FIntVector& CubeMax, FPlanetChunkSectionResult& Section)
+{
+	using namespace FastRealtimeMarchingCubeMesher;
+
+	const TArray<FTriangulationData>& TriangulationTable = *Input.TriangulationTable;
+	const float PerCubeHalfSize = Input.StepSize * 0.5f;
+	const FIntVector CubeRes = CubeMax - CubeMin;
+
+	// Chunk bounds for the skirt pass
+	const bool bSkirts = Input.SkirtDepth > 0.0f;
+	const FVector3f ChunkMin = Input.InitialOffsetPosition;
+	const FVector3f ChunkMax = Input.InitialOffsetPosition + FVector3f(Input.StepSize * Input.CubeCount);
+	const float PlaneTolerance = Input.StepSize * 0.01f;
+
+	// Returns a bitmask of which of the 6 chunk boundary planes a position lies on
+	auto BoundaryPlanes = [&](const FVector3f& P)
+	{
+		uint32 Planes = 0;
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			Planes |= FMath::Abs(P[Axis] - ChunkMin[Axis]) <= PlaneTolerance ? (1u << (Axis * 2)) : 0u;
+			Planes |= FMath::Abs(P[Axis] - ChunkMax[Axis]) <= PlaneTolerance ? (1u << (Axis * 2 + 1)) : 0u;
+		}
+		return Planes;
+	};
+
+	auto GetCubePosition = [&](int32 X, int32 Y, int32 Z)
+	{
+		return Input.InitialOffsetPosition + PerCubeHalfSize + FVector3f(Input.StepSize * X, Input.StepSize * Y, Input.StepSize * Z);
+	};
+
+	// Vertex position for entry i of a cube's triangulation data
+	auto GetVertexPosition = [&](const FVector3f& CubePosition, const FTriangulationData& TriangulationData, int32 i)
+	{
+		const FVector3f PO = (TriangulationData.Vertices[i] - 1.0f);
+		return CubePosition - (PO * PerCubeHalfSize);
+	};
+
+	// Classification pass. Find each cube's case a row at a time from the density grid, then count exactly what the fill pass
+	// will write for the cubes that have surface, so the streams are allocated once
+	TArray<uint8> CubeCases;
+	CubeCases.SetNumUninitialized(CubeRes.X * CubeRes.Y * CubeRes.Z);
+	int32 VertexCount = 0;
+	int32 TriangleCount = 0;
+	int32 SkirtEdgeCount = 0;
+	{
+		TERRAIN_STAGE_SCOPE(Classification);
+
+		for (int32 Z = CubeMin.Z; Z < CubeMax.Z; Z++)
+		{
+			for (int32 Y = CubeMin.Y; Y < CubeMax.Y; Y++)
+			{
+				// Density grid offsets of the 4 sample rows bounding this row of cubes
+				const FIntVector Local = FIntVector(CubeMin.X, Y, Z) - Input.SnapshotOrigin;
+				const int32 RowStride = Input.SnapshotRes.X;
+				const int32 SliceStride = Input.SnapshotRes.X * Input.SnapshotRes.Y;
+				const int32 RowOffset = Local.X + (Local.Y * RowStride) + (Local.Z * SliceStride);
+				const uint8* SampleRows[4] = {
+					&Density[RowOffset],
+					&Density[RowOffset + RowStride],
+					&Density[RowOffset + SliceStride],
+					&Density[RowOffset + RowStride + SliceStride] };
+
+				uint8* RowCases = &CubeCases[((Z - CubeMin.Z) * CubeRes.Y + (Y - CubeMin.Y)) * CubeRes.X];
+				for (int32 X = 0; X < CubeRes.X; X += 8)
+				{
+					const int32 GroupCount = FMath::Min(CubeRes.X - X, 8);
+					uint64 Cases = ClassifyCubes(SampleRows, X);
+
+					// Skip all 8 cubes at once if they're all empty or all solid, which is most of them on a mostly empty planet
+					if (Cases == 0 || Cases == ~0ull)
+					{
+						FMemory::Memzero(&RowCases[X], GroupCount);
+						continue;
+					}
+
+					for (int32 i = X; i < X + GroupCount; i++)
+					{
+						// Byte n of the group holds cube X + n's case, the same order LoadWord packed the samples in
+						uint8& CubeCase = RowCases[i];
+						CubeCase = static_cast<uint8>(Cases >> ((i - X) * 8));
+						const int32 CubeX = CubeMin.X + i;
+
+						// Skip invalid data table index values
+						if (CubeCase == 0 || CubeCase == 255 || !TriangulationTable.IsValidIndex(CubeCase - 1))
+						{
+							CubeCase = 0;
+							continue;
+						}
+
+						// Skip cubes past planet surface point
+						const FVector3f CubePosition = GetCubePosition(CubeX, Y, Z);
+						if (FMath::Abs(CubePosition.Length()) - Input.StepSize > Input.SkipRadius)
+						{
+							CubeCase = 0;
+							continue;
+						}
+
+						const FTriangulationData& TriangulationData = TriangulationTable[CubeCase - 1];
+						VertexCount += TriangulationData.Vertices.Num();
+						TriangleCount += TriangulationData.Triangles.Num() / 3;
+
+						// Only cubes touching the chunk boundary can have skirt edges
+						const bool bBoundaryCube = CubeX == 0 || Y == 0 || Z == 0 || CubeX == Input.CubeCount - 1 || Y == Input.CubeCount - 1 || Z == Input.CubeCount - 1;
+						if (bSkirts && bBoundaryCube)
+						{
+							for (int32 Tri = 0; Tri + 2 < TriangulationData.Triangles.Num(); Tri += 3)
+							{
+								for (int32 Edge = 0; Edge < 3; Edge++)
+								{
+									const FVector3f PositionA = GetVertexPosition(CubePosition, TriangulationData, TriangulationData.Triangles[Tri + Edge]);
+									const FVector3f PositionB = GetVertexPosition(CubePosition, TriangulationData, TriangulationData.Triangles[Tri + ((Edge + 1) % 3)]);
+									SkirtEdgeCount += (BoundaryPlanes(PositionA) & BoundaryPlanes(PositionB)) != 0 ? 1 : 0;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (TriangleCount == 0)
+	{
+		return 0;
+	}
+
+	// Every skirt edge adds 2 verts & 2 tris
+	FSectionBuilders Builders(Section.StreamSet, VertexCount + (SkirtEdgeCount * 2), TriangleCount + (SkirtEdgeCount * 2));
+
+	// Set up holdover flat tri array to track max tri index offsets as we cook tries along the way
+	int32 MaxTri = 0;
+	int32 CurrentMaxTri = MaxTri;
+
+	// Fill pass. Store the triangulation data of every classified cube to our streams
+	FVector3f CornerGradients[8];
+	int32 CaseIndex = 0;
+	{
+		TERRAIN_STAGE_SCOPE(StreamBuild);
+
+		for (int32 Z = CubeMin.Z; Z < CubeMax.Z; Z++)
+		{
+			for (int32 Y = CubeMin.Y; Y < CubeMax.Y; Y++)
+			{
+				for (int32 X = CubeMin.X; X < CubeMax.X; X++)
+				{
+					const uint8 CubeCase = CubeCases[CaseIndex++];
+					if (CubeCase == 0)
+					{
+						continue;
+					}
+
+					const FTriangulationData& TriangulationData = TriangulationTable[CubeCase - 1];
+					const FVector3f CubePosition = GetCubePosition(X, Y, Z);
+					GetCornerGradients(Input, FIntVector(X, Y, Z), CornerGradients);
+
+					for (int32 i = 0; i < TriangulationData.Vertices.Num(); i++)
+					{
+						// Vertex Positions
+						Builders.Position.Add(GetVertexPosition(CubePosition, TriangulationData, i));
+
+						// Normals Tangents, from the field gradient at the vert rather than the case's flat normals. Table verts run
+						// from 2 at the cube's min corner to 0 at its max
+						const FVector3f Gradient = BlendGradients(CornerGradients, (FVector3f(2.0f) - TriangulationData.Vertices[i]) * 0.5f);
+						Builders.Tangents.Add(MakeGradientTangents(Gradient, TriangulationData.Normals[i], TriangulationData.Tangents[i]));
+
+						// Vertex Colors
+						Builders.Color.Add(FColor::Black);
+
+						// UVs
+						Builders.TexCoords.Add(FVector2DHalf(TriangulationData.UV0[i]));
+					}
+
+					// Triangles are in a flat array, so they're packed in groups of 3
+					for (int32 i = 0; i + 2 < TriangulationData.Triangles.Num(); i += 3)
+					{
+						const int32 T0 = TriangulationData.Triangles[i] + MaxTri;
+						const int32 T1 = TriangulationData.Triangles[i + 1] + MaxTri;
+						const int32 T2 = TriangulationData.Triangles[i + 2] + MaxTri;
+						Builders.AddTriangle(TIndex3<uint32>(T0, T1, T2));
+
+						// Compare max tri values for incrementing after this loop
+						CurrentMaxTri = FMath::Max3(CurrentMaxTri, T0, FMath::Max(T1, T2));
+					}
+
+					// Increment tri count index
+					MaxTri = CurrentMaxTri;
+					if (MaxTri > 0)
+					{
+						MaxTri += 1;
+					}
+				}
+			}
+		}
+	}
+
+	// Hang skirts off every triangle edge lying on the chunk boundary, pulled in towards the planet center. Neighbours meshed
+	// at a different LOD place their boundary verts differently, & the skirts fill the cracks that leaves between them
+	if (SkirtEdgeCount > 0)
+	{
+		TERRAIN_STAGE_SCOPE(Skirts);
+
+		const int32 SurfaceTriCount = Builders.NumTriangles();
+		for (int32 TriIndex = 0; TriIndex < SurfaceTriCount; TriIndex++)
+		{
+			const TIndex3<uint32> Tri = Builders.GetTriangle(TriIndex);
+			for (int32 Edge = 0; Edge < 3; Edge++)
+			{
+				const uint32 A = Tri[Edge];
+				const uint32 B = Tri[(Edge + 1) % 3];
+				const FVector3f PositionA = Builders.Position.Get(A);
+				const FVector3f PositionB = Builders.Position.Get(B);
+
+				// Only edges with both ends on the same boundary plane get a skirt
+				if ((BoundaryPlanes(PositionA) & BoundaryPlanes(PositionB)) == 0)
+				{
+					continue;
+				}
+
+				// Duplicate both edge verts, pushed in towards the planet center, & copy their attributes across
+				const int32 SkirtBase = Builders.Position.Num();
+				Builders.Position.Add(PositionA - (PositionA.GetSafeNormal() * Input.SkirtDepth));
+				Builders.Position.Add(PositionB - (PositionB.GetSafeNormal() * Input.SkirtDepth));
+				Builders.Tangents.Add(Builders.Tangents.Get(A));
+				Builders.Tangents.Add(Builders.Tangents.Get(B));
+				Builders.Color.Add(Builders.Color.Get(A));
+				Builders.Color.Add(Builders.Color.Get(B));
+				Builders.TexCoords.Add(Builders.TexCoords.Get(A));
+				Builders.TexCoords.Add(Builders.TexCoords.Get(B));
+
+				// Wind the skirt as if it were the neighbouring triangle across this edge, so it faces the same way as the surface
+				Builders.AddTriangle(TIndex3<uint32>(B, A, SkirtBase));
+				Builders.AddTriangle(TIndex3<uint32>(B, SkirtBase, SkirtBase + 1));
+			}
+		}
+
+		MaxTri = Builders.Position.Num();
+	}
+
+	Section.VertexCount = Builders.Position.Num();
+	Section.TriangleCount = Builders.NumTriangles();
+	return MaxTri;
+}
+
+int32 FFastRealtimeMarchingCubeMesher::BuildSurfaceNetsSection(const FPlanetChunkBuildInput& Input, const FIntVector& CubeMin, const FIntVector& CubeMax, FPlanetChunkSectionResult& Section)
+{
+	using namespace FastRealtimeMarchingCubeMesher;
+
+	// Cells from one before the section's first cube are needed for quads on the section's min faces. Quads on its max faces
+	// belong to the next section over, so every edge of the field is owned by exactly one section
+	const FIntVector CellMin = CubeMin - FIntVector(1);
+	const FIntVector CellRes = CubeMax - CellMin;
+	const int32 CellCount = CellRes.X * CellRes.Y * CellRes.Z;
+	auto CellIndex = [&](const FIntVector& Cell)
+	{
+		const FIntVector Local = Cell - CellMin;
+		return Local.X + (Local.Y * CellRes.X) + (Local.Z * CellRes.X * CellRes.Y);
+	};
+
+	// Corner i of a cell is offset by its X, Y & Z bits
+	auto GetCellCorners = [&](const FIntVector& Cell, float (&CornerValues)[8])
+	{
+		uint32 Mask = 0;
+		for (int32 i = 0; i < 8; i++)
+		{
+			CornerValues[i] = GetSnapshotSample(Input, Cell + FIntVector(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+			Mask |= CornerValues[i] >= IsoLevel ? (1u << i) : 0u;
+		}
+		return Mask;
+	};
+
+	// Classification pass. Every cell the surface passes through gets the index of the vertex it'll place, & each cell's corner
+	// mask is kept so the quad passes can find sign changes without going back to the snapshot
+	TArray<uint8> CellMasks;
+	TArray<int32> CellVertices;
+	CellMasks.SetNumUninitialized(CellCount);
+	CellVertices.Init(INDEX_NONE, CellCount);
+	int32 VertexCount = 0;
+	float CornerValues[8];
+	{
+		TERRAIN_STAGE_SCOPE(Classification);
+
+		for (int32 Z = CellMin.Z; Z < CubeMax.Z; Z++)
+		{
+			for (int32 Y = CellMin.Y; Y < CubeMax.Y; Y++)
+			{
+				for (int32 X = CellMin.X; X < CubeMax.X; X++)
+				{
+					const int32 Index = CellIndex(FIntVector(X, Y, Z));
+					const uint32 Mask = GetCellCorners(FIntVector(X, Y, Z), CornerValues);
+					CellMasks[Index] = static_cast<uint8>(Mask);
+					if (Mask == 0 || Mask == 255)
+					{
+						continue;
+					}
+
+					// Skip cells past planet surface point
+					const FVector3f CellCenter = Input.InitialOffsetPosition + FVector3f(Input.StepSize * (X + 0.5f), Input.StepSize * (Y + 0.5f), Input.StepSize * (Z + 0.5f));
+					if (FMath::Abs(CellCenter.Length()) - Input.StepSize > Input.SkipRadius)
+					{
+						continue;
+					}
+
+					CellVertices[Index] = VertexCount++;
+				}
+			}
+		}
+	}
+
+	// Calls Func(V0, V1, V2, V3, bSolid, Axis) for every edge the surface crosses whose 4 surrounding cells all have a vertex
+	auto ForEachQuad = [&](auto&& Func)
+	{
+		for (int32 Z = CubeMin.Z; Z < CubeMax.Z; Z++)
+		{
+			for (int32 Y = CubeMin.Y; Y < CubeMax.Y; Y++)
+			{
+				for (int32 X = CubeMin.X; X < CubeMax.X; X++)
+				{
+					// The sample is corner 0 of its own cell, & its neighbour along each axis is that axis's corner
+					const FIntVector Sample = FIntVector(X, Y, Z);
+					const uint32 Mask = CellMasks[CellIndex(Sample)];
+					const bool bSolid = (Mask & 1) == 0;
+
+					for (int32 Axis = 0; Axis < 3; Axis++)
+					{
+						if (bSolid == (((Mask >> (1 << Axis)) & 1) == 0))
+						{
+							continue;
+						}
+
+						// The other two axes step back to the cells sharing this edge
+						FIntVector StepU = FIntVector::ZeroValue;
+						FIntVector StepV = FIntVector::ZeroValue;
+						StepU[(Axis + 1) % 3] = 1;
+						StepV[(Axis + 2) % 3] = 1;
+						const int32 V0 = CellVertices[CellIndex(Sample - StepU - StepV)];
+						const int32 V1 = CellVertices[CellIndex(Sample - StepV)];
+						const int32 V2 = CellVertices[CellIndex(Sample)];
+						const int32 V3 = CellVertices[CellIndex(Sample - StepU)];
+						if (V0 != INDEX_NONE && V1 != INDEX_NONE && V2 != INDEX_NONE && V3 != INDEX_NONE)
+						{
+							Func(V0, V1, V2, V3, bSolid, Axis);
+						}
+					}
+				}
+			}
+		}
+	};
+
+	int32 QuadCount = 0;
+	ForEachQuad([&](int32, int32, int32, int32, bool, int32) { QuadCount++; });
+	if (QuadCount == 0)
+	{
+		return 0;
+	}
+
+	FSectionBuilders Builders(Section.StreamSet, VertexCount, QuadCount * 2);
+
+	// Fill pass. Place each surface cell's vertex in the order its index was handed out
+	FVector3f CornerGradients[8];
+	{
+		TERRAIN_STAGE_SCOPE(StreamBuild);
+
+		for (int32 Z = CellMin.Z; Z < CubeMax.Z; Z++)
+		{
+			for (int32 Y = CellMin.Y; Y < CubeMax.Y; Y++)
+			{
+				for (int32 X = CellMin.X; X < CubeMax.X; X++)
+				{
+					if (CellVertices[CellIndex(FIntVector(X, Y, Z))] == INDEX_NONE)
+					{
+						continue;
+					}
+					const uint32 Mask = GetCellCorners(FIntVector(X, Y, Z), CornerValues);
+
+					// Average where the surface crosses the cell's 12 edges
+					FVector3f CrossingSum = FVector3f::ZeroVector;
+					int32 CrossingCount = 0;
+					for (int32 i = 0; i < 8; i++)
+					{
+						for (int32 Axis = 0; Axis < 3; Axis++)
+						{
+							const int32 j = i | (1 << Axis);
+							if (j == i || ((Mask >> i) & 1) == ((Mask >> j) & 1))
+							{
+								continue;
+							}
+							const float T = FMath::Clamp((IsoLevel - CornerValues[i]) / (CornerValues[j] - CornerValues[i]), 0.0f, 1.0f);
+							const FVector3f CornerI = FVector3f(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+							const FVector3f CornerJ = FVector3f(j & 1, (j >> 1) & 1, (j >> 2) & 1);
+							CrossingSum += CornerI + ((CornerJ - CornerI) * T);
+							CrossingCount++;
+						}
+					}
+					const FVector3f CellOffset = CrossingSum / CrossingCount;
+
+					// Normal from the field gradient at the vert, falling back to pointing away from the planet center
+					const FVector3f Position = Input.InitialOffsetPosition + ((FVector3f(X, Y, Z) + CellOffset) * Input.StepSize);
+					GetCornerGradients(Input, FIntVector(X, Y, Z), CornerGradients);
+					const FVector3f UpNormal = Position.GetSafeNormal();
+					const FRealtimeMeshTangentsHighPrecision Tangents = MakeGradientTangents(BlendGradients(CornerGradients, CellOffset), UpNormal,
+						FVector3f::CrossProduct(UpNormal, FMath::Abs(UpNormal.Z) < 0.99f ? FVector3f::UpVector : FVector3f::ForwardVector).GetSafeNormal());
+					const FVector3f Normal = Tangents.GetNormal();
+
+					Builders.Position.Add(Position);
+					Builders.Tangents.Add(Tangents);
+					Builders.Color.Add(FColor::Black);
+
+					// Project the in-cell offset along the dominant normal axis, like the table's per-cube UVs
+					const FVector3f AbsNormal = Normal.GetAbs();
+					const FVector2f UV = AbsNormal.Z >= AbsNormal.X && AbsNormal.Z >= AbsNormal.Y ? FVector2f(CellOffset.X, CellOffset.Y)
+						: AbsNormal.Y >= AbsNormal.X ? FVector2f(CellOffset.X, CellOffset.Z) : FVector2f(CellOffset.Y, CellOffset.Z);
+					Builders.TexCoords.Add(UV);
+				}
+			}
+		}
+	}
+
+	TERRAIN_STAGE_SCOPE(IndexBuild);
+
+	// Join the 4 cells around every edge the surface crosses with a quad, facing away from the solid side of the edge
+	ForEachQuad([&](int32 V0, int32 V1, int32 V2, int32 V3, bool bSolid, int32 Axis)
+	{
+		FVector3f Outward = FVector3f::ZeroVector;
+		Outward[Axis] = bSolid ? 1.0f : -1.0f;
+		const FVector3f P0 = Builders.Position.Get(V0);
+		const FVector3f FaceNormal = FVector3f::CrossProduct(Builders.Position.Get(V2) - P0, Builders.Position.Get(V1) - P0);
+		if (FVector3f::DotProduct(FaceNormal, Outward) >= 0.0f)
+		{
+			Builders.AddTriangle(TIndex3<uint32>(V0, V1, V2));
+			Builders.AddTriangle(TIndex3<uint32>(V0, V2, V3));
+		}
+		else
+		{
+			Builders.AddTriangle(TIndex3<uint32>(V0, V2, V1));
+			Builders.AddTriangle(TIndex3<uint32>(V0, V3, V2));
+		}
+	});
+
+	Section.VertexCount = Builders.Position.Num();
+	Section.TriangleCount = Builders.NumTriangles();
+	return Builders.Position.Num();
+}
+
+int32 FFastRealtimeMarchingCubeMesher::GetMaxSectionSize(EPlanetMesherType MesherType, const FPlanetTriangulationTablePtr& TriangulationTable, bool bSkirts)
+{
+	// Surface nets places at most one vertex per cell, & a section of N cubes reads N + 1 cells along each side
+	if (MesherType == EPlanetMesherType::SurfaceNets)
+	{
+		int32 SectionSize = 1;
+		while (Uses16BitIndices(FMath::Cube(SectionSize + 2)))
+		{
+			SectionSize++;
+		}
+		return SectionSize;
+	}
+
+	if (!TriangulationTable.IsValid())
+	{
+		return MAX_int32;
+	}
+
+	// Most verts & tris any single case adds
+	int32 MaxCubeVertices = 0;
+	int32 MaxCubeTriangles = 0;
+	for (const FTriangulationData& TriangulationData : *TriangulationTable)
+	{
+		MaxCubeVertices = FMath::Max(MaxCubeVertices, TriangulationData.Vertices.Num());
+		MaxCubeTriangles = FMath::Max(MaxCubeTriangles, TriangulationData.Triangles.Num() / 3);
+	}
+	if (MaxCubeVertices == 0)
+	{
+		return MAX_int32;
+	}
+
+	// Cubes on the section's faces can also hang 2 skirt verts off each of their triangle edges
+	const int32 MaxSkirtVertices = bSkirts ? MaxCubeTriangles * 3 * 2 : 0;
+	auto WorstCaseVertexCount = [&](int64 SectionSize)
+	{
+		return (FMath::Cube(SectionSize) * MaxCubeVertices) + (6 * FMath::Square(SectionSize) * MaxSkirtVertices);
+	};
+
+	int32 SectionSize = 1;
+	while (WorstCaseVertexCount(SectionSize + 1) <= MAX_uint16)
+	{
+		SectionSize++;
+	}
+	return SectionSize;
+}
+
+int32 FFastRealtimeMarchingCubeMesher::BinaryFromVertices(const TArray<float>& Vertices)
+{
+	// Verts at or above the iso level are outside the surface & set their bit, values may not be exactly 0 or 1 once quantized
+	int32 T = 0;
+	for (int32 i = 0; i < 8; i++)
+	{
+		if (Vertices[i] >= IsoLevel)
+		{
+			T |= 1 << i;
+		}
+	}
+
+	return T;
+}
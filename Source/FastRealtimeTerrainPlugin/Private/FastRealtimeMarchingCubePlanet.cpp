@@ -3,9 +3,15 @@
 
 #include "FastRealtimeMarchingCubePlanet.h"
 #include "DrawDebugHelpers.h"
+#include "FastRealtimeTerrainStats.h"
+#include "FastRealtimeTerrainSubsystem.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "GuidStructCustomization.h"
+#include "Hash/CityHash.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
 
 AFastRealtimeMarchingCubePlanet::AFastRealtimeMarchingCubePlanet()
 {
@@ -41,31 +47,116 @@ void AFastRealtimeMarchingCubePlanet::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 
-	const FDateTime LastCacheTime = FDateTime::Now();
+	TERRAIN_STAGE_SCOPE(Tick);
+
+	// Close off the recorded frame this tick is about to act on, along with any edits made since the last one
+	if (FlightRecording.IsSet())
+	{
+		if (GetEditOpCount() > RecordedEditOpCount)
+		{
+			GetEditJournalRange(RecordedEditOpCount, GetEditOpCount() - RecordedEditOpCount, RecordingFrame.EditJournal);
+			RecordedEditOpCount = GetEditOpCount();
+		}
+		RecordingFrame.DeltaSeconds = DeltaSeconds;
+		FlightRecording->Frames.Add(MoveTemp(RecordingFrame));
+		RecordingFrame = FTerrainFlightPathFrame();
+	}
+
+	// Apply this frame's edits first so the chunks they dirty launch alongside any other pending work
+	ApplyPendingGeoEdits();
+
+	// Leave pending chunks to the terrain subsystem when it's scheduling this planet, otherwise spend our own budget on them
+	const bool bScheduled = bUseTerrainScheduler && UFastRealtimeTerrainSubsystem::IsSchedulingEnabled(GetWorld());
+	const float BudgetUsed = bScheduled ? 0.0f : ProcessPendingWork(BuildChunkTimeBudget);
+
+	RetireSettledOctreeChunks();
+
+	if (bMemoryUsageDirty)
+	{
+		UpdateMemoryUsage();
+	}
+
+	// Report what's left queued & how much of the chunk build budget this frame used, scheduled budgets are reported by the subsystem
+	INC_DWORD_STAT_BY(STAT_TerrainPendingChunks, PendingTerrainChunks.Num() + PendingOctreeChunks.Num());
+	INC_DWORD_STAT_BY(STAT_TerrainInFlightBuilds, InFlightChunkBuilds.Num());
+	if (!bScheduled)
+	{
+		INC_FLOAT_STAT_BY(STAT_TerrainBudget, BuildChunkTimeBudget);
+		INC_FLOAT_STAT_BY(STAT_TerrainBudgetUsed, BudgetUsed);
+	}
+}
+
+float AFastRealtimeMarchingCubePlanet::ProcessPendingWork(float BudgetMs)
+{
+	const double StartTime = FPlatformTime::Seconds();
 	bool BuildTimeExceeded = false;
 
-	while (PendingTerrainChunks.Num() != 0 && BuildTimeExceeded == false)
+	// Apply any chunk builds that finished on worker tasks, this is the only part of chunk meshing left on the game thread
+	for (int32 i = 0; i < InFlightChunkBuilds.Num() && BuildTimeExceeded == false;)
 	{
+		if (!InFlightChunkBuilds[i].IsCompleted())
+		{
+			i++;
+			continue;
+		}
 
-		if (DebugOnlyDrawOneChunk)
+		const TSharedPtr<FPlanetChunkBuildResult, ESPMode::ThreadSafe> Result = InFlightChunkBuilds[i].GetResult();
+		InFlightChunkBuilds.RemoveAtSwap(i);
+		if (Result.IsValid())
 		{
-			GenerateTerrainChunk(PendingTerrainChunks[SingleChunk]);
-			PendingTerrainChunks.Empty();
-			return;
+			ApplyChunkBuildResult(*Result);
+		}
+
+		// Check if applying results exceeded the per-frame chunk build time budget, if so, delay remaining results to future frames
+		if ((FPlatformTime::Seconds() - StartTime) * 1000.0 > BudgetMs)
+		{
+			BuildTimeExceeded = true;
 		}
-		// Generate the first chunk in the stack
-		GenerateTerrainChunk(PendingTerrainChunks[0]);
+	}
+
+	// Cap in-flight builds so we don't snapshot chunks faster than the workers can mesh them
+	const int32 MaxInFlightBuilds = MaxConcurrentChunkBuilds > 0 ? MaxConcurrentChunkBuilds : FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads());
+
+	while ((PendingTerrainChunks.Num() != 0 || PendingOctreeChunks.Num() != 0) && BuildTimeExceeded == false && (!bAsyncChunkBuilds || InFlightChunkBuilds.Num() < MaxInFlightBuilds))
+	{
+		if (PendingTerrainChunks.Num() != 0)
+		{
+			if (DebugOnlyDrawOneChunk)
+			{
+				GenerateTerrainChunk(PendingTerrainChunks[SingleChunk]);
+				PendingTerrainChunks.Empty();
+				break;
+			}
+			// Generate the first chunk in the stack
+			GenerateTerrainChunk(PendingTerrainChunks[0]);
 
-		// Move the generated chunk to the end of the stack & then remove it, shrinking the stack down
-		PendingTerrainChunks.Swap(0, PendingTerrainChunks.Num() - 1);
-		PendingTerrainChunks.Pop();
+			// Move the generated chunk to the end of the stack & then remove it, shrinking the stack down
+			PendingTerrainChunks.Swap(0, PendingTerrainChunks.Num() - 1);
+			PendingTerrainChunks.Pop();
+		}
+		else
+		{
+			// Octree leaves are sorted closest first, so keep building from the front
+			const FPlanetChunkKey ChunkKey = PendingOctreeChunks[0];
+			PendingOctreeChunks.RemoveAt(0);
+			GenerateOctreeChunk(ChunkKey, false);
+		}
 
 		// Check if the process of generating that chunk exceeded the per-fame chunk build time budget, if so, delay remaining chunks to future frames
-		if ((FDateTime::Now() - LastCacheTime).GetTotalMilliseconds() > BuildChunkTimeBudget)
+		if ((FPlatformTime::Seconds() - StartTime) * 1000.0 > BudgetMs)
 		{
 			BuildTimeExceeded = true;
 		}
 	}
+
+	return static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+float AFastRealtimeMarchingCubePlanet::GetPendingWorkDistance() const
+{
+	const float SurfaceRadius = SurfaceHeight * PlanetSize * 0.5f * GetActorScale3D().GetMax();
+	const FVector ObserverLocation = UKismetMathLibrary::TransformLocation(GetActorTransform(), ObserverLocalPosition);
+	return FMath::Max(FVector::Dist(ObserverLocation, GetActorLocation()) - SurfaceRadius, 0.0f);
 }
 
 void AFastRealtimeMarchingCubePlanet::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
@@ -89,6 +180,8 @@ void AFastRealtimeMarchingCubePlanet::BeginPlay()
 
 void AFastRealtimeMarchingCubePlanet::GenerateMesh()
 {
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
 	ClearGeneratedMesh();
 
 	const FVector3f InitialOffsetPosition = FVector3f(PlanetSize * -0.5f);
@@ -109,90 +202,89 @@ void AFastRealtimeMarchingCubePlanet::GenerateMesh()
 		FlushPersistentDebugLines(GetWorld());
 	}
 
-	FDateTime ScalarGatherStartTime = FDateTime::Now();
-
 	// Initialize Point Values Array for use in the below loop
-	TArray<float> PointValues;
-	PointValues.SetNumUninitialized(8);
-	
-	// Loop through XYZ grid cube vert positions for scalar field values
-	for (int32 Z = 0; Z < CubeRes; Z++)
 	{
-		for (int32 Y = 0; Y < CubeRes; Y++)
+		TERRAIN_STAGE_SCOPE(NoiseSampling);
+
+		TArray<float> PointValues;
+		PointValues.SetNumUninitialized(8);
+	
+		// Loop through XYZ grid cube vert positions for scalar field values
+		for (int32 Z = 0; Z < CubeRes; Z++)
 		{
-			for (int32 X = 0; X < CubeRes; X++)
+			for (int32 Y = 0; Y < CubeRes; Y++)
 			{
+				for (int32 X = 0; X < CubeRes; X++)
+				{
 				
-				// Store Current Cube Position
-				FVector3f CurrentCubePosition = InitialOffsetPosition + FVector3f(PerCubeHalfSize) + FVector3f(StepSize * X, StepSize * Y, StepSize * Z);
+					// Store Current Cube Position
+					FVector3f CurrentCubePosition = InitialOffsetPosition + FVector3f(PerCubeHalfSize) + FVector3f(StepSize * X, StepSize * Y, StepSize * Z);
 
-				// Optional Debugging
-				if (DrawDebugCubeEdges)
-				{
-					DrawDebugBox(
-						GetWorld(),
-						UKismetMathLibrary::TransformLocation(GetActorTransform(),FVector(CurrentCubePosition)),
-						FVector(PerCubeHalfSize),
-						FColor(125, 125, 125, 255),
-						false,
-						5.0f,
-						0,
-						1.0f
-						);
-				}
+					// Optional Debugging
+					if (DrawDebugCubeEdges)
+					{
+						DrawDebugBox(
+							GetWorld(),
+							UKismetMathLibrary::TransformLocation(GetActorTransform(),FVector(CurrentCubePosition)),
+							FVector(PerCubeHalfSize),
+							FColor(125, 125, 125, 255),
+							false,
+							5.0f,
+							0,
+							1.0f
+							);
+					}
 				
-				// Skip cube vert checks if past planet surface point
-				if (FMath::Abs(CurrentCubePosition.Length()) - StepSize > PlanetSize * 0.5f)
-				{
-					continue;
-				}
-	
-				// From each cube center, step out to each cube vertex & get a density value. For now just from a distance falloff, later w/ noise blend
-				//for (FVector3f Direction : VertexDirections)
-				for (int32 i = 0; i < 8; i++)
-				{
-					const FVector3f Direction = VertexDirections[i];
-					const FVector3f VertPosition = CurrentCubePosition + (Direction * PerCubeHalfSize);
-					const float NoiseValue = UFastNoiseLayeringFunctions::BlendNoises3D(FVector(VertPosition), NoiseWrappers, NoiseLayers) * NoiseDisplacementStrength;
-					const float DistanceNormalized = (VertPosition.Size() + NoiseValue) / (PlanetSize * 0.5f);
-					float VertValue = 1.0f;
-					if (DistanceNormalized < SurfaceHeight)
+					// Skip cube vert checks if past planet surface point
+					if (FMath::Abs(CurrentCubePosition.Length()) - StepSize > PlanetSize * 0.5f)
 					{
-						VertValue = 0.0f;
+						continue;
 					}
-					PointValues[i] = VertValue;
-
-					// Optional Debugging
-					if (DrawDebugCubeVerts)
+	
+					// From each cube center, step out to each cube vertex & get a density value. For now just from a distance falloff, later w/ noise blend
+					//for (FVector3f Direction : VertexDirections)
+					for (int32 i = 0; i < 8; i++)
 					{
-						FColor PointColor = FColor::Black;
+						const FVector3f Direction = VertexDirections[i];
+						const FVector3f VertPosition = CurrentCubePosition + (Direction * PerCubeHalfSize);
+						const float NoiseValue = UFastNoiseLayeringFunctions::BlendNoises3D(FVector(VertPosition), NoiseWrappers, NoiseLayers) * NoiseDisplacementStrength;
+						const float DistanceNormalized = (VertPosition.Size() + NoiseValue) / (PlanetSize * 0.5f);
+						float VertValue = 1.0f;
 						if (DistanceNormalized < SurfaceHeight)
 						{
-							PointColor = FColor::White;
+							VertValue = 0.0f;
+						}
+						PointValues[i] = VertValue;
+
+						// Optional Debugging
+						if (DrawDebugCubeVerts)
+						{
+							FColor PointColor = FColor::Black;
+							if (DistanceNormalized < SurfaceHeight)
+							{
+								PointColor = FColor::White;
+							}
+							DrawDebugPoint(
+								GetWorld(),
+								UKismetMathLibrary::TransformLocation(GetActorTransform(), FVector(VertPosition)),
+								5.0f,
+								PointColor,
+								false,
+								5.0f
+								);
 						}
-						DrawDebugPoint(
-							GetWorld(),
-							UKismetMathLibrary::TransformLocation(GetActorTransform(), FVector(VertPosition)),
-							5.0f,
-							PointColor,
-							false,
-							5.0f
-							);
 					}
-				}
 	
-				// Add cube center & cube vert scalar values to CubeData
-				FCubeData CD;
-				CD.CubePosition = CurrentCubePosition;
-				CD.VertexValues = PointValues;
-				CubeData.CubeDatum.Add(CD);
+					// Add cube center & cube vert scalar values to CubeData
+					FCubeData CD;
+					CD.CubePosition = CurrentCubePosition;
+					CD.VertexValues = PointValues;
+					CubeData.CubeDatum.Add(CD);
+				}
 			}
 		}
 	}
 
-	const int32 ScalarGatherTime = (FDateTime::Now() - ScalarGatherStartTime).GetTotalMilliseconds();
-	//UE_LOG(LogTemp, Log, TEXT("%i point Scalar Field Gather took %i ms"), CubeRes * CubeRes * CubeRes * 4,ScalarGatherTime);
-
 	// Initialize Realtime Mesh & Streams// Initialize Realtime Mesh Simple
 	URealtimeMeshSimple* RTM = GetRealtimeMeshComponent()->InitializeRealtimeMesh<URealtimeMeshSimple>();
 
@@ -215,10 +307,6 @@ void AFastRealtimeMarchingCubePlanet::GenerateMesh()
 	TRealtimeMeshStreamBuilder<FColor> ColorBuilder(
 		StreamSet.AddStream(FRealtimeMeshStreams::Color, GetRealtimeMeshBufferLayout<FColor>()));
 
-	// Set up a stream for tris
-	TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint32>> TrianglesBuilder(
-		StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint32>>()));
-
 	// Set up a stream for polygroups
 	TRealtimeMeshStreamBuilder<uint32, uint16> PolygroupsBuilder(
 	StreamSet.AddStream(FRealtimeMeshStreams::PolyGroups, GetRealtimeMeshBufferLayout<uint16>()));
@@ -231,89 +319,132 @@ void AFastRealtimeMarchingCubePlanet::GenerateMesh()
 
 	InitializeTriangulationTableData();
 
-	FDateTime TableDataLookupStartTime = FDateTime::Now();
+	// Count exactly what the table lookups below will write, so each stream is only allocated once
+	int32 VertexCount = 0;
+	int32 TriangleCount = 0;
+	if (TriangulationTableData.IsValid())
+	{
+		for (const FCubeData& CD : CubeData.CubeDatum)
+		{
+			const int32 TriTableIndex = FFastRealtimeMarchingCubeMesher::BinaryFromVertices(CD.VertexValues);
+			if (TriTableIndex > 0 && TriTableIndex < 255 && TriangulationTableData->IsValidIndex(TriTableIndex - 1))
+			{
+				VertexCount += (*TriangulationTableData)[TriTableIndex - 1].Vertices.Num();
+				TriangleCount += (*TriangulationTableData)[TriTableIndex - 1].Triangles.Num() / 3;
+			}
+		}
+	}
+	PositionBuilder.Reserve(VertexCount);
+	TangentBuilder.Reserve(VertexCount);
+	ColorBuilder.Reserve(VertexCount);
+	TexCoordsBuilder.Reserve(VertexCount);
+	PolygroupsBuilder.Reserve(TriangleCount);
+
+	// Set up a stream for tris, 16 bit unless the mesh has more verts than 16 bit indices can address
+	TOptional<TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>>> TrianglesBuilder16;
+	TOptional<TRealtimeMeshStreamBuilder<TIndex3<uint32>>> TrianglesBuilder32;
+	if (FFastRealtimeMarchingCubeMesher::Uses16BitIndices(VertexCount))
+	{
+		TrianglesBuilder16.Emplace(StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint16>>()));
+		TrianglesBuilder16->Reserve(TriangleCount);
+	}
+	else
+	{
+		TrianglesBuilder32.Emplace(StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint32>>()));
+		TrianglesBuilder32->Reserve(TriangleCount);
+	}
+
 	FTriangulationData TriangulationData;
 
 	// Loop through all CubeData entries, get their triangulation data, and store it to our realtime mesh streams
-	for (FCubeData& CD : CubeData.CubeDatum)
 	{
-		// Look for the data table index value, skip if it's invalid
-		const int32 TriTableIndex = BinaryFromVertices(CD.VertexValues);
-		if (TriTableIndex <= 0 || TriTableIndex >= 255)
+		TERRAIN_STAGE_SCOPE(StreamBuild);
+
+		for (FCubeData& CD : CubeData.CubeDatum)
 		{
-			continue;
-		}
+			// Look for the data table index value, skip if it's invalid
+			const int32 TriTableIndex = FFastRealtimeMarchingCubeMesher::BinaryFromVertices(CD.VertexValues);
+			if (TriTableIndex <= 0 || TriTableIndex >= 255)
+			{
+				continue;
+			}
 
-		// Grab triangulation data from DT
-		GetTriangulationData(TriangulationData, TriTableIndex);
+			// Grab triangulation data from DT
+			GetTriangulationData(TriangulationData, TriTableIndex);
 
-		for (int32 i = 0; i < TriangulationData.Vertices.Num(); i++)
-		{
-			// Vertex Positions
-			FVector3f PO = (TriangulationData.Vertices[i] - 1.0f);
-			FVector3f Position = (PO * PerCubeHalfSize);
-			PositionBuilder.Add(CD.CubePosition - FVector3f(Position));
+			for (int32 i = 0; i < TriangulationData.Vertices.Num(); i++)
+			{
+				// Vertex Positions
+				FVector3f PO = (TriangulationData.Vertices[i] - 1.0f);
+				FVector3f Position = (PO * PerCubeHalfSize);
+				PositionBuilder.Add(CD.CubePosition - FVector3f(Position));
 
-			// Normals Tangents
-			FRealtimeMeshTangentsHighPrecision NT = FRealtimeMeshTangentsHighPrecision(TriangulationData.Normals[i], TriangulationData.Tangents[i]);
-			TangentBuilder.Add(NT);
+				// Normals Tangents
+				FRealtimeMeshTangentsHighPrecision NT = FRealtimeMeshTangentsHighPrecision(TriangulationData.Normals[i], TriangulationData.Tangents[i]);
+				TangentBuilder.Add(NT);
 
-			// Vertex Colors
-			ColorBuilder.Add(FColor::Black);
+				// Vertex Colors
+				ColorBuilder.Add(FColor::Black);
 
-			// UVs
-			TexCoordsBuilder.Add(FVector2DHalf(TriangulationData.UV0[i]));
-		}
+				// UVs
+				TexCoordsBuilder.Add(FVector2DHalf(TriangulationData.UV0[i]));
+			}
 		
-		for (int32 i = 0; i < TriangulationData.Triangles.Num(); i++)
-		{
-			
-			// Triangles are tricky, they're in a flat array, so they must be done in groups of 3 every 3 entries
-			if (ModCounter == 0)
+			for (int32 i = 0; i < TriangulationData.Triangles.Num(); i++)
 			{
-				TrianglesBuilder.Add(TIndex3<uint32>(TriangulationData.Triangles[i] + MaxTri, TriangulationData.Triangles[i + 1] + MaxTri, TriangulationData.Triangles[i + 2] + MaxTri));
-				PolygroupsBuilder.Add(0);
-
-				// Compare max tri values for incrementing after this loop
-				if (TriangulationData.Triangles[i] + MaxTri > CurrentMaxTri)
-				{
-					CurrentMaxTri = TriangulationData.Triangles[i] + MaxTri;
-				}
-				if (TriangulationData.Triangles[i + 1] + MaxTri > CurrentMaxTri)
+			
+				// Triangles are tricky, they're in a flat array, so they must be done in groups of 3 every 3 entries
+				if (ModCounter == 0)
 				{
-					CurrentMaxTri = TriangulationData.Triangles[i + 1] + MaxTri;
+					const TIndex3<uint32> Triangle(TriangulationData.Triangles[i] + MaxTri, TriangulationData.Triangles[i + 1] + MaxTri, TriangulationData.Triangles[i + 2] + MaxTri);
+					if (TrianglesBuilder16.IsSet())
+					{
+						TrianglesBuilder16->Add(Triangle);
+					}
+					else
+					{
+						TrianglesBuilder32->Add(Triangle);
+					}
+					PolygroupsBuilder.Add(0);
+
+					// Compare max tri values for incrementing after this loop
+					if (TriangulationData.Triangles[i] + MaxTri > CurrentMaxTri)
+					{
+						CurrentMaxTri = TriangulationData.Triangles[i] + MaxTri;
+					}
+					if (TriangulationData.Triangles[i + 1] + MaxTri > CurrentMaxTri)
+					{
+						CurrentMaxTri = TriangulationData.Triangles[i + 1] + MaxTri;
+					}
+					if (TriangulationData.Triangles[i + 2] + MaxTri > CurrentMaxTri)
+					{
+						CurrentMaxTri = TriangulationData.Triangles[i + 2] + MaxTri;
+					}
+
+					// Increment in-loop "every-three" counter to avoid using modulo
+					ModCounter += 1;
 				}
-				if (TriangulationData.Triangles[i + 2] + MaxTri > CurrentMaxTri)
+				else
 				{
-					CurrentMaxTri = TriangulationData.Triangles[i + 2] + MaxTri;
+					ModCounter += 1;
+					if (ModCounter >= 3)
+					{
+						ModCounter = 0;
+					}
 				}
-
-				// Increment in-loop "every-three" counter to avoid using modulo
-				ModCounter += 1;
 			}
-			else
+
+			// Increment tri count index
+			MaxTri = CurrentMaxTri;
+			if (MaxTri > 0)
 			{
-				ModCounter += 1;
-				if (ModCounter >= 3)
-				{
-					ModCounter = 0;
-				}
+				MaxTri += 1;
 			}
 		}
-
-		// Increment tri count index
-		MaxTri = CurrentMaxTri;
-		if (MaxTri > 0)
-		{
-			MaxTri += 1;
-		}
 	}
 
-	const int32 TableDataLookupTime = (FDateTime::Now() - TableDataLookupStartTime).GetTotalMilliseconds();
-	//UE_LOG(LogTemp, Log, TEXT("Table Data lookup took %i ms for %i CD instances"), TableDataLookupTime, CubeData.CubeDatum.Num());
+	TERRAIN_STAGE_SCOPE(SectionCommit);
 
-	FDateTime MeshUpdateStartTime = FDateTime::Now();
-	
 	// Setup the material slot
 	RTM->SetupMaterialSlot(0, "PrimaryMaterial");
 	
@@ -327,12 +458,12 @@ void AFastRealtimeMarchingCubePlanet::GenerateMesh()
 	// Now we create the section group
 	RTM->CreateSectionGroup(GroupKey, StreamSet);
 	
-	// Update the configuration of the polygroup section
+	// Update the configuration of the polygroup section, which hands it to the collision cook
+	TERRAIN_STAGE_SCOPE(CollisionUpdate);
 	RTM->UpdateSectionConfig(PolyGroup0SectionKey, FRealtimeMeshSectionConfig(0), DoCollision);
 
-	const int32 MeshUpdateTime = (FDateTime::Now() - MeshUpdateStartTime).GetTotalMilliseconds();
-	//UE_LOG(LogTemp, Log, TEXT("Mesh Update took %i ms"), MeshUpdateTime);
-	
+	RootMeshMemoryUsage = FTerrainMemoryUsage::ForMeshSection(VertexCount, TriangleCount, DoCollision);
+	bMemoryUsageDirty = true;
 }
 
 void AFastRealtimeMarchingCubePlanet::GenerateMeshDeferred()
@@ -342,20 +473,29 @@ void AFastRealtimeMarchingCubePlanet::GenerateMeshDeferred()
 	InitializeTriangulationTableData();
 	InitializeScalarField();
 
-	const int32 ComponentCount = ComponentBreakupScale * ComponentBreakupScale * ComponentBreakupScale;
+	// Octree chunks are queued from the observer position instead of all at once
+	if (bUseOctreeLOD)
+	{
+		UpdateOctree();
+		return;
+	}
 	
 	// Loop through the volume component subdivisions, adding new components at each subdivision center
 	const float StepSize = PlanetSize / ComponentBreakupScale;
 	const float PerCompHalfSize = StepSize * 0.5f;
-	const FVector StartingOffset = FVector(PlanetSize * -0.5f) + PerCompHalfSize;
 	for (int32 Z = 0; Z < ComponentBreakupScale; Z++)
 	{
 		for (int32 Y = 0; Y < ComponentBreakupScale; Y++)
 		{
 			for (int32 X = 0; X < ComponentBreakupScale; X++)
 			{
-				const FVector CellOffset = StartingOffset + FVector(X * StepSize, Y * StepSize, Z * StepSize);
-				PendingTerrainChunks.Add(CellOffset);
+				const FVector CellOffset = ChunkCenterFromCoord(FIntVector(X, Y, Z));
+
+				// Chunks that are entirely solid or entirely empty have nothing to mesh
+				if (ChunkCanContainSurface(FIntVector(X, Y, Z)))
+				{
+					PendingTerrainChunks.Add(CellOffset);
+				}
 				if (DrawDebugCubeVerts)
 				{
 					DrawDebugBox(
@@ -376,68 +516,67 @@ void AFastRealtimeMarchingCubePlanet::GenerateMeshDeferred()
 
 void AFastRealtimeMarchingCubePlanet::GenerateTerrainChunk(const FVector TileCenter, bool Update)
 {
+	const FIntVector ChunkCoord = ChunkCoordFromCenter(TileCenter);
 
-	// // If updating this chunk, find the existing comp & destroy it. Probably a better way to do this but idk
-	// if (Update)
-	// {
-	// 	TArray<URealtimeMeshComponent*> Keys;
-	// 	GeneratedMeshComps.GetKeys(Keys);
-	// 	for (URealtimeMeshComponent* GRTM : Keys)
-	// 	{
-	// 		if (GeneratedMeshComps[GRTM] == TileCenter)
-	// 		{
-	// 			GRTM->DestroyComponent();
-	// 			break;
-	// 		}
-	// 	}
-	// }
-
-	URealtimeMeshSimple* NRTM = nullptr;
-	URealtimeMeshComponent* NewMeshComp = nullptr;
-
-	if (Update)
-	{
-		//UE_LOG(LogTemp, Log, TEXT("Update is True"));
-		TArray<URealtimeMeshComponent*> Keys;
-		GeneratedMeshComps.GetKeys(Keys);
-		for (URealtimeMeshComponent* RTM : Keys)
-		{
-			if (GeneratedMeshComps[RTM] == TileCenter)
-			{
-				//UE_LOG(LogTemp, Log, TEXT("Found RTM from tile center"));
-				NewMeshComp = RTM;
-				NRTM = NewMeshComp->InitializeRealtimeMesh<URealtimeMeshSimple>();
-				FRealtimeMeshCollisionConfiguration CollisionConfig;
-				CollisionConfig.bDeformableMesh = true;
-				CollisionConfig.bUseComplexAsSimpleCollision = true;
-				CollisionConfig.bUseAsyncCook = true;
-				CollisionConfig.bMergeAllMeshes = false;
-				NRTM->SetCollisionConfig(CollisionConfig);
-				break;
-			}
-		}
+	// Reuse the chunk's comp whenever it already has one, as a chunk an edit built before its queued build came up would
+	// otherwise be given a second one. Rebuilding an existing comp is always an update so its old geometry gets cleared, &
+	// chunks that had nothing to mesh until now get a new comp
+	URealtimeMeshComponent* NewMeshComp = ChunkMeshComps.FindRef(ChunkCoord);
+	if (NewMeshComp)
+	{
+		Update = true;
 	}
 	else
 	{
-		// // Initialize a new RealtimeMesh for each chunk
-		NewMeshComp = NewObject<URealtimeMeshComponent>(this, URealtimeMeshComponent::StaticClass());
-		NewMeshComp->RegisterComponent();
-		NewMeshComp->SetCollisionProfileName("BlockAll");
-		NewMeshComp->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::SnapToTargetIncludingScale);
-		GeneratedMeshComps.Add(NewMeshComp, TileCenter);
-
-		// Initialize realtime mesh simple
-		NRTM = NewMeshComp->InitializeRealtimeMesh<URealtimeMeshSimple>();
-		FRealtimeMeshCollisionConfiguration CollisionConfig;
-		CollisionConfig.bDeformableMesh = true;
-		CollisionConfig.bUseComplexAsSimpleCollision = true;
-		CollisionConfig.bUseAsyncCook = true;
-		CollisionConfig.bMergeAllMeshes = false;
-		NRTM->SetCollisionConfig(CollisionConfig);
-	}
-
-	//const FVector3f InitialOffsetPosition = FVector3f(PlanetSize * -0.5f);
-	const FVector3f InitialOffsetPosition = FVector3f(TileCenter - FVector((PlanetSize / ComponentBreakupScale) * 0.5f));
+		Update = false;
+		NewMeshComp = CreateChunkMeshComp(TileCenter);
+		ChunkMeshComps.Add(ChunkCoord, NewMeshComp);
+	}
+
+	LaunchChunkBuild(FPlanetChunkKey(ChunkCoord, 0), NewMeshComp, Update);
+}
+
+void AFastRealtimeMarchingCubePlanet::GenerateOctreeChunk(const FPlanetChunkKey& ChunkKey, bool Update)
+{
+	URealtimeMeshComponent* NewMeshComp = OctreeMeshComps.FindRef(ChunkKey);
+
+	// Leaves that had nothing to mesh until now get a new comp
+	if (!NewMeshComp)
+	{
+		Update = false;
+		NewMeshComp = CreateChunkMeshComp(GetChunkBounds(ChunkKey).GetCenter());
+		OctreeMeshComps.Add(ChunkKey, NewMeshComp);
+	}
+
+	LaunchChunkBuild(ChunkKey, NewMeshComp, Update);
+}
+
+URealtimeMeshComponent* AFastRealtimeMarchingCubePlanet::CreateChunkMeshComp(const FVector& ChunkCenter)
+{
+	// Initialize a new RealtimeMesh for each chunk
+	URealtimeMeshComponent* NewMeshComp = NewObject<URealtimeMeshComponent>(this, URealtimeMeshComponent::StaticClass());
+	NewMeshComp->RegisterComponent();
+	NewMeshComp->SetCollisionProfileName("BlockAll");
+	NewMeshComp->AttachToComponent(GetRootComponent(), FAttachmentTransformRules::SnapToTargetIncludingScale);
+	GeneratedMeshComps.Add(NewMeshComp, ChunkCenter);
+	InitializeChunkRealtimeMesh(NewMeshComp);
+	return NewMeshComp;
+}
+
+void AFastRealtimeMarchingCubePlanet::LaunchChunkBuild(const FPlanetChunkKey& ChunkKey, URealtimeMeshComponent* MeshComp, bool Update, TArray<FIntVector> SectionBricks)
+{
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
+	if (!TriangulationTableDataInitialized)
+	{
+		InitializeTriangulationTableData();
+	}
+
+	// Every LOD meshes the same number of cubes, stepping over 2^LOD samples per cube
+	const int32 SampleStride = 1 << ChunkKey.LOD;
+	const float StepSize = (PlanetSize / (ComponentBreakupScale * PerCompRes)) * SampleStride;
+	const float PerCubeHalfSize = StepSize * 0.5f;
+	const FVector3f InitialOffsetPosition = FVector3f(GetChunkBounds(ChunkKey).Min);
 	if (DrawDebugCubeVerts)
 	{
 		DrawDebugSphere(
@@ -452,36 +591,17 @@ void AFastRealtimeMarchingCubePlanet::GenerateTerrainChunk(const FVector TileCen
 			2.5f
 			);
 	}
-	const float VolumeSize = PlanetSize / ComponentBreakupScale;
-	const float StepSize = VolumeSize / PerCompRes;
-	const float PerCubeHalfSize = StepSize * 0.5f;
-
-	// Initialize Point Values Array for use in the below loop
-	TArray<float> PointValues;
-	PointValues.SetNumUninitialized(8);
 
-	int32 index = -1;
-
-	int32 ResOffset = 0;
-
-	FDateTime ScalarGatherStartTime = FDateTime::Now();
-	
-	// Loop through XYZ grid cube vert positions for scalar field values
-	for (int32 Z = 0; Z < PerCompRes - ResOffset; Z++)
+	// Optional Debugging
+	if (DrawDebugCubeEdges)
 	{
-		for (int32 Y = 0; Y < PerCompRes - ResOffset; Y++)
+		for (int32 Z = 0; Z < PerCompRes; Z++)
 		{
-			for (int32 X = 0; X < PerCompRes - ResOffset; X++)
+			for (int32 Y = 0; Y < PerCompRes; Y++)
 			{
-
-				index++;
-				
-				// Store Current Cube Position
-				FVector3f CurrentCubePosition = InitialOffsetPosition + PerCubeHalfSize + FVector3f(StepSize * X, StepSize * Y, StepSize * Z);
-
-				// Optional Debugging
-				if (DrawDebugCubeEdges)
+				for (int32 X = 0; X < PerCompRes; X++)
 				{
+					const FVector3f CurrentCubePosition = InitialOffsetPosition + PerCubeHalfSize + FVector3f(StepSize * X, StepSize * Y, StepSize * Z);
 					DrawDebugBox(
 						GetWorld(),
 						UKismetMathLibrary::TransformLocation(GetActorTransform(),FVector(CurrentCubePosition)),
@@ -493,208 +613,235 @@ void AFastRealtimeMarchingCubePlanet::GenerateTerrainChunk(const FVector TileCen
 						1.0f
 						);
 				}
-				
-				// Skip cube vert checks if past planet surface point
-				if (FMath::Abs(CurrentCubePosition.Length()) - StepSize > PlanetSize * 0.5f)
-				{
-					continue;
-				}
-	
-				// From each cube center, step out to each cube vertex & get a density value. For now just from a distance falloff, later w/ noise blend
-				//for (FVector3f Direction : VertexDirections)
-				for (int32 i = 0; i < 8; i++)
-				{
-					const FVector3f Direction = VertexDirections[i];
-					const FVector3f VertPosition = CurrentCubePosition + (Direction * PerCubeHalfSize);
-					const int32 LookupIndex = ScalarIndexLookupFromLocalLocation(FVector(VertPosition));
-					const FVector NormalizedPosition = FVector(VertPosition) + (PlanetSize * 0.5f);
-					//UE_LOG(LogTemp, Log, TEXT("NormalizedPosition = %s | Index X = %i | Index Y = %i | Index Z = %i | LookupIndex = %i"), *NormalizedPosition.ToString(), IndexX, IndexY, IndexZ, LookupIndex);
-
-					FColor DebugBoxColor = FColor::Orange;
-					if (ScalarField.IsValidIndex(LookupIndex))
-					{
-						PointValues[i] = ScalarField[LookupIndex];
-						DebugBoxColor = FColor(ScalarField[LookupIndex] * 255,ScalarField[LookupIndex] * 255,ScalarField[LookupIndex] * 255,ScalarField[LookupIndex] * 255);
-						//UE_LOG(LogTemp, Log, TEXT("Found Scalar Value %f from key %i at position %s normalized position %s"), ScalarField[LookupIndex], LookupIndex, *FVector(VertPosition).ToString(), *FVector(NormalizedPosition).ToString());
-					}
-					else
-					{
-						//UE_LOG(LogTemp, Log, TEXT("Could not find Scalar Value from key %i at position %s normalized position %s"), LookupIndex, *FVector(VertPosition).ToString(), *FVector(NormalizedPosition).ToString());
-					}
-					// if (DrawDebugCubeVerts)
-					// {
-					// 	DrawDebugBox(
-					// 		GetWorld(),
-					// 		UKismetMathLibrary::TransformLocation(GetActorTransform(), FVector(NormalizedPosition)),
-					// 		FVector(10.0f),
-					// 		DebugBoxColor,
-					// 		false,
-					// 		5.0f,
-					// 		0,
-					// 		2.0f
-					// 		);
-					// }
-				}
-	
-				// Add cube center & cube vert scalar values to CubeData
-				FCubeData CD;
-				CD.CubePosition = CurrentCubePosition;
-				CD.VertexValues = PointValues;
-				CubeData.CubeDatum.Add(CD);
 			}
 		}
 	}
 
-	const int32 ScalarGatherTime = (FDateTime::Now() - ScalarGatherStartTime).GetTotalMilliseconds();
-	//UE_LOG(LogTemp, Log, TEXT("Scalar Field Gather took %i ms"), ScalarGatherTime);
-	
-	// Initialize StreamSet. If RealtimeMeshSimple = DynamicMeshComponent, then StreamSet = DynamicMesh object
-	FRealtimeMeshStreamSet StreamSet;
-	
-	// Set up a stream for vertex positions
-	TRealtimeMeshStreamBuilder<FVector3f> PositionBuilder(
-		StreamSet.AddStream(FRealtimeMeshStreams::Position, GetRealtimeMeshBufferLayout<FVector3f>()));
-	
-	// Set up a stream for tangents
-	TRealtimeMeshStreamBuilder<FRealtimeMeshTangentsHighPrecision, FRealtimeMeshTangentsNormalPrecision> TangentBuilder(
-		StreamSet.AddStream(FRealtimeMeshStreams::Tangents, GetRealtimeMeshBufferLayout<FRealtimeMeshTangentsNormalPrecision>()));
-	
-	// Set up a stream for texcoords
-	TRealtimeMeshStreamBuilder<FVector2f, FVector2DHalf> TexCoordsBuilder(
-		StreamSet.AddStream(FRealtimeMeshStreams::TexCoords, GetRealtimeMeshBufferLayout<FVector2DHalf>()));
-	
-	// Set up a stream for vertex colors
-	TRealtimeMeshStreamBuilder<FColor> ColorBuilder(
-		StreamSet.AddStream(FRealtimeMeshStreams::Color, GetRealtimeMeshBufferLayout<FColor>()));
-	
-	// Set up a stream for tris
-	TRealtimeMeshStreamBuilder<TIndex3<uint32>, TIndex3<uint16>> TrianglesBuilder(
-		StreamSet.AddStream(FRealtimeMeshStreams::Triangles, GetRealtimeMeshBufferLayout<TIndex3<uint16>>()));
-	
-	// Set up a stream for polygroups
-	TRealtimeMeshStreamBuilder<uint32, uint16> PolygroupsBuilder(
-	StreamSet.AddStream(FRealtimeMeshStreams::PolyGroups, GetRealtimeMeshBufferLayout<uint16>()));
-	
-	// Set up holdover flat tri array to track max tri index offsets as we cook tries along the way
-	int32 MaxTri = 0;
-	int32 ModCounter = 0;
-	int32 CurrentMaxTri = MaxTri;
-	TArray<FVector> Positions;
-	
-	FDateTime TableDataLookupStartTime = FDateTime::Now();
-	FTriangulationData TriangulationData;
-	
-	// Loop through all CubeData entries, get their triangulation data, and store it to our realtime mesh streams
-	for (FCubeData& CD : CubeData.CubeDatum)
+	// A build that hasn't been applied yet is about to be superseded & dropped, so this one has to cover its sections as well
+	FPlanetChunkBuildState& BuildState = ChunkBuildStates.FindOrAdd(MeshComp);
+	if (BuildState.bInFlight && SectionBricks.Num() > 0)
 	{
-		// Look for the data table index value, skip if it's invalid
-		const int32 TriTableIndex = BinaryFromVertices(CD.VertexValues);
-		if (TriTableIndex <= 0 || TriTableIndex >= 255)
-		{
-			continue;
-		}
-	
-		// Grab triangulation data from DT
-		GetTriangulationData(TriangulationData, TriTableIndex);
-	
-		for (int32 i = 0; i < TriangulationData.Vertices.Num(); i++)
+		if (BuildState.SectionBricks.Num() == 0)
 		{
-			// Vertex Positions
-			FVector3f PO = (TriangulationData.Vertices[i] - 1.0f);
-			FVector3f Position = (PO * PerCubeHalfSize);
-			PositionBuilder.Add(CD.CubePosition - FVector3f(Position));
-	
-			// Normals Tangents
-			FRealtimeMeshTangentsHighPrecision NT = FRealtimeMeshTangentsHighPrecision(TriangulationData.Normals[i], TriangulationData.Tangents[i]);
-			TangentBuilder.Add(NT);
-	
-			// Vertex Colors
-			ColorBuilder.Add(FColor::Black);
-	
-			// UVs
-			TexCoordsBuilder.Add(FVector2DHalf(TriangulationData.UV0[i]));
+			SectionBricks.Empty();
 		}
-		
-		for (int32 i = 0; i < TriangulationData.Triangles.Num(); i++)
+		else
 		{
-			
-			// Triangles are tricky, they're in a flat array, so they must be done in groups of 3 every 3 entries
-			if (ModCounter == 0)
-			{
-				TrianglesBuilder.Add(TIndex3<uint32>(TriangulationData.Triangles[i] + MaxTri, TriangulationData.Triangles[i + 1] + MaxTri, TriangulationData.Triangles[i + 2] + MaxTri));
-				PolygroupsBuilder.Add(0);
-	
-				// Compare max tri values for incrementing after this loop
-				if (TriangulationData.Triangles[i] + MaxTri > CurrentMaxTri)
-				{
-					CurrentMaxTri = TriangulationData.Triangles[i] + MaxTri;
-				}
-				if (TriangulationData.Triangles[i + 1] + MaxTri > CurrentMaxTri)
-				{
-					CurrentMaxTri = TriangulationData.Triangles[i + 1] + MaxTri;
-				}
-				if (TriangulationData.Triangles[i + 2] + MaxTri > CurrentMaxTri)
-				{
-					CurrentMaxTri = TriangulationData.Triangles[i + 2] + MaxTri;
-				}
-	
-				// Increment in-loop "every-three" counter to avoid using modulo
-				ModCounter += 1;
-			}
-			else
+			for (const FIntVector& SectionBrick : BuildState.SectionBricks)
 			{
-				ModCounter += 1;
-				if (ModCounter >= 3)
-				{
-					ModCounter = 0;
-				}
+				SectionBricks.AddUnique(SectionBrick);
 			}
 		}
-	
-		// Increment tri count index
-		MaxTri = CurrentMaxTri;
-		if (MaxTri > 0)
+	}
+
+	// Build an immutable snapshot of the chunk's region of the scalar field for the mesher to read from
+	const TSharedRef<FPlanetChunkBuildInput, ESPMode::ThreadSafe> Input = MakeShared<FPlanetChunkBuildInput, ESPMode::ThreadSafe>();
+	Input->MeshComp = MeshComp;
+	Input->ChunkKey = ChunkKey;
+	Input->BuildSerial = ++NextChunkBuildSerial;
+	Input->bUpdate = Update;
+	Input->InitialOffsetPosition = InitialOffsetPosition;
+	Input->MesherType = MesherType;
+	Input->CubeCount = PerCompRes;
+	Input->StepSize = StepSize;
+	Input->SkipRadius = PlanetSize * 0.5f;
+	Input->SkirtDepth = bUseOctreeLOD && bStitchLODSeams ? StepSize * 2.0f : 0.0f;
+	Input->SectionSize = GetSectionSize();
+	Input->bOptimizeVertexCache = bOptimizeVertexCache;
+	Input->SectionBricks = SectionBricks;
+	Input->TriangulationTable = TriangulationTableData;
+
+	// Only snapshot the cube range covered by the section bricks being built
+	FIntVector CubeMin = FIntVector::ZeroValue;
+	FIntVector CubeMax = FIntVector(PerCompRes);
+	if (SectionBricks.Num() > 0)
+	{
+		const int32 SectionSize = Input->SectionSize;
+		CubeMin = FIntVector(MAX_int32);
+		CubeMax = FIntVector(MIN_int32);
+		for (const FIntVector& SectionBrick : SectionBricks)
 		{
-			MaxTri += 1;
+			const FIntVector BrickMin = SectionBrick * SectionSize;
+			CubeMin = FIntVector(FMath::Min(CubeMin.X, BrickMin.X), FMath::Min(CubeMin.Y, BrickMin.Y), FMath::Min(CubeMin.Z, BrickMin.Z));
+			CubeMax = FIntVector(
+				FMath::Max(CubeMax.X, FMath::Min(BrickMin.X + SectionSize, PerCompRes)),
+				FMath::Max(CubeMax.Y, FMath::Min(BrickMin.Y + SectionSize, PerCompRes)),
+				FMath::Max(CubeMax.Z, FMath::Min(BrickMin.Z + SectionSize, PerCompRes)));
 		}
 	}
-	
-	const int32 TableDataLookupTime = (FDateTime::Now() - TableDataLookupStartTime).GetTotalMilliseconds();
-	//UE_LOG(LogTemp, Log, TEXT("Table Data lookup took %i ms for %i CD instances"), TableDataLookupTime, CubeData.CubeDatum.Num());
 
-	TotalTriCount += MaxTri;
+	// Normals are taken from the field gradient, so the snapshot reaches a little past the range on both sides
+	CubeMin -= FIntVector(FFastRealtimeMarchingCubeMesher::GetSnapshotApron(MesherType));
+	CubeMax += FIntVector(FFastRealtimeMarchingCubeMesher::GetSnapshotApron(MesherType));
+	Input->SnapshotOrigin = CubeMin;
+	Input->SnapshotRes = CubeMax - CubeMin + FIntVector(1);
 
-	// Don't update mesh section if no geo to update with
-	if (MaxTri == 0)
+	// Snapshot every sample the build reads
 	{
-		//UE_LOG(LogTemp, Log, TEXT("MaxTri = 0, aborting update"));
-		return;
-	}
-	
-	FDateTime MeshUpdateStartTime = FDateTime::Now();
+		TERRAIN_STAGE_SCOPE(ChunkSnapshot);
+
+		// First scalar sample the chunk covers
+		const FIntVector SampleOrigin = ChunkKey.Coord * (PerCompRes * SampleStride);
+
+		Input->Samples.SetNumUninitialized(Input->SnapshotRes.X * Input->SnapshotRes.Y * Input->SnapshotRes.Z);
+		int32 SampleIndex = 0;
+		for (int32 Z = CubeMin.Z; Z <= CubeMax.Z; Z++)
+		{
+			for (int32 Y = CubeMin.Y; Y <= CubeMax.Y; Y++)
+			{
+				for (int32 X = CubeMin.X; X <= CubeMax.X; X++)
+				{
+					// Samples outside of the field are treated as empty space
+					const FIntVector S = SampleOrigin + FIntVector(X, Y, Z) * SampleStride;
+					Input->Samples[SampleIndex++] = ScalarField.IsValidSample(S) ? ScalarField.GetSample(S) : 1.0f;
+				}
+			}
+		}
+
+		// Edits are layered over the base snapshot by the build, in the order they were made
+		TArray<int32> ChunkOps;
+		GatherChunkEditOps(ChunkKey, ChunkOps);
+		Input->EditOps.Reserve(ChunkOps.Num());
+		for (const int32 OpIndex : ChunkOps)
+		{
+			Input->EditOps.Add(EditOps[OpIndex]);
+		}
+		Input->FieldSampleOrigin = SampleOrigin;
+		Input->FieldSampleStride = SampleStride;
+		Input->FieldSampleStep = PlanetSize / (ComponentBreakupScale * PerCompRes);
+		Input->FieldOrigin = FVector3f(PlanetSize * -0.5f);
+	}
+
+	BuildState.ChunkKey = ChunkKey;
+	BuildState.LatestSerial = Input->BuildSerial;
+	BuildState.bInFlight = true;
+	BuildState.SectionBricks = MoveTemp(SectionBricks);
+
+	if (bAsyncChunkBuilds)
+	{
+		// Mesh the snapshot on a worker task, the result gets applied from tick once it's done
+		InFlightChunkBuilds.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [Input]()
+		{
+			TSharedPtr<FPlanetChunkBuildResult, ESPMode::ThreadSafe> Result = MakeShared<FPlanetChunkBuildResult, ESPMode::ThreadSafe>();
+			FFastRealtimeMarchingCubeMesher::ApplyEditOps(*Input);
+			FFastRealtimeMarchingCubeMesher::BuildChunk(*Input, *Result);
+			return Result;
+		}));
+	}
+	else
+	{
+		FPlanetChunkBuildResult Result;
+		FFastRealtimeMarchingCubeMesher::ApplyEditOps(*Input);
+		FFastRealtimeMarchingCubeMesher::BuildChunk(*Input, Result);
+		ApplyChunkBuildResult(Result);
+	}
+}
+
+URealtimeMeshSimple* AFastRealtimeMarchingCubePlanet::InitializeChunkRealtimeMesh(URealtimeMeshComponent* MeshComp) const
+{
+	// Initialize realtime mesh simple
+	URealtimeMeshSimple* NRTM = MeshComp->InitializeRealtimeMesh<URealtimeMeshSimple>();
+	FRealtimeMeshCollisionConfiguration CollisionConfig;
+	CollisionConfig.bDeformableMesh = true;
+	CollisionConfig.bUseComplexAsSimpleCollision = true;
+	CollisionConfig.bUseAsyncCook = true;
+	CollisionConfig.bMergeAllMeshes = false;
+	NRTM->SetCollisionConfig(CollisionConfig);
+	return NRTM;
+}
+
+void AFastRealtimeMarchingCubePlanet::ApplyChunkBuildResult(FPlanetChunkBuildResult& Result)
+{
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+
+	// Drop results for comps that have since been destroyed, or that were superseded by a newer build of the same chunk
+	URealtimeMeshComponent* MeshComp = Result.MeshComp.Get();
+	if (!MeshComp || !GeneratedMeshComps.Contains(MeshComp))
+	{
+		return;
+	}
+	FPlanetChunkBuildState* BuildState = ChunkBuildStates.Find(MeshComp);
+	if (!BuildState || BuildState->LatestSerial != Result.BuildSerial)
+	{
+		return;
+	}
+	BuildState->bInFlight = false;
+
+	// This octree leaf has caught up, so anything it's replacing can be retired
+	if (OctreeMeshComps.FindRef(Result.ChunkKey) == MeshComp)
+	{
+		UnsettledOctreeChunks.Remove(Result.ChunkKey);
+	}
+
+	// Full updates replace the whole realtime mesh so any previous geometry is cleared, even if this result is empty. Partial
+	// updates only touch the section groups they rebuilt
+	const bool bResetMesh = Result.bUpdate && Result.bAllSections;
+	URealtimeMeshSimple* NRTM = bResetMesh ? InitializeChunkRealtimeMesh(MeshComp) : Cast<URealtimeMeshSimple>(MeshComp->GetRealtimeMesh());
+	if (!NRTM)
+	{
+		return;
+	}
+	if (bResetMesh)
+	{
+		BuildState->BuiltSections.Empty();
+		bMemoryUsageDirty = true;
+	}
+
+	for (const FPlanetChunkSectionResult& Section : Result.Sections)
+	{
+		TotalVertCount += Section.VertexCount;
+	}
+
+	// Don't update mesh sections if no geo to update with & no existing sections to clear
+	if (Result.MaxTri == 0 && BuildState->BuiltSections.Num() == 0)
+	{
+		return;
+	}
+
+	TERRAIN_STAGE_SCOPE(SectionCommit);
+	bMemoryUsageDirty = true;
 
-	//UE_LOG(LogTemp, Log, TEXT("MaxTri = %i"), MaxTri);
-	
 	// Setup the material slot
 	NRTM->SetupMaterialSlot(0, "PrimaryMaterial");
-	
-	// Setup the group key
-	const FRealtimeMeshSectionGroupKey GroupKey = FRealtimeMeshSectionGroupKey::Create(0, FName(TEXT("RTM%i"), 0));
-	
-	// Setup the section key
-	const FRealtimeMeshSectionKey PolyGroupSectionKey = FRealtimeMeshSectionKey::CreateForPolyGroup(GroupKey, 0);
-	SectionKeys.Add(PolyGroupSectionKey);
-	
-	// Now we create the section group
-	NRTM->CreateSectionGroup(GroupKey, StreamSet);
-	
-	// Update the configuration of the polygroup section
-	NRTM->UpdateSectionConfig(PolyGroupSectionKey, FRealtimeMeshSectionConfig(0), DoCollision);
-	
-	const int32 MeshUpdateTime = (FDateTime::Now() - MeshUpdateStartTime).GetTotalMilliseconds();
-	//UE_LOG(LogTemp, Log, TEXT("Mesh Update took %i ms"), MeshUpdateTime);
 
-	CubeData.CubeDatum.Empty();
+	for (FPlanetChunkSectionResult& Section : Result.Sections)
+	{
+		// Setup the group key, each section brick gets its own group
+		const FRealtimeMeshSectionGroupKey GroupKey = FRealtimeMeshSectionGroupKey::Create(0, FName(*FString::Printf(TEXT("RTM%i"), Section.SectionIndex)));
+
+		// Sections the rebuild left empty are removed
+		if (Section.MaxTri == 0)
+		{
+			if (BuildState->BuiltSections.Remove(Section.SectionIndex) > 0)
+			{
+				NRTM->RemoveSectionGroup(GroupKey);
+			}
+			continue;
+		}
+
+		// Existing sections just get their streams replaced
+		FPlanetBuiltSection BuiltSection;
+		BuiltSection.MemoryUsage = FTerrainMemoryUsage::ForMeshSection(Section.VertexCount, Section.TriangleCount, DoCollision);
+		BuiltSection.TriangleCount = Section.TriangleCount;
+		if (FPlanetBuiltSection* ExistingSection = BuildState->BuiltSections.Find(Section.SectionIndex))
+		{
+			NRTM->UpdateSectionGroup(GroupKey, MoveTemp(Section.StreamSet));
+			*ExistingSection = BuiltSection;
+			continue;
+		}
+
+		// Setup the section key
+		const FRealtimeMeshSectionKey PolyGroupSectionKey = FRealtimeMeshSectionKey::CreateForPolyGroup(GroupKey, 0);
+		SectionKeys.Add(PolyGroupSectionKey);
+
+		// Now we create the section group
+		NRTM->CreateSectionGroup(GroupKey, MoveTemp(Section.StreamSet));
+		BuildState->BuiltSections.Add(Section.SectionIndex, BuiltSection);
+
+		// Update the configuration of the polygroup section, which hands it to the collision cook
+		TERRAIN_STAGE_SCOPE(CollisionUpdate);
+		NRTM->UpdateSectionConfig(PolyGroupSectionKey, FRealtimeMeshSectionConfig(0), DoCollision);
+	}
 
 	Super::OnGenerateMesh_Implementation();
 }
@@ -708,7 +855,19 @@ void AFastRealtimeMarchingCubePlanet::ClearGeneratedMesh()
 	SectionKeys.Empty();
 	TriangulationTableDataInitialized = false;
 	PendingTerrainChunks.Empty();
+	InFlightChunkBuilds.Empty();
+	ChunkBuildStates.Empty();
 	ScalarField.Empty();
+	ChunkDensityRanges.Empty();
+	ChunkMeshComps.Empty();
+	EditOps.Empty();
+	ChunkEditOps.Empty();
+	PendingEditOps.Empty();
+	OctreeLeaves.Empty();
+	OctreeMeshComps.Empty();
+	PendingOctreeChunks.Empty();
+	UnsettledOctreeChunks.Empty();
+	RetiringOctreeChunks.Empty();
 	TArray<URealtimeMeshComponent*> Keys;
 	GeneratedMeshComps.GetKeys(Keys);
 	for (URealtimeMeshComponent* GRMC : Keys)
@@ -721,16 +880,166 @@ void AFastRealtimeMarchingCubePlanet::ClearGeneratedMesh()
 	}
 	GeneratedMeshComps.Empty();
 	TotalTriCount = 0;
+	TotalVertCount = 0;
+	RootMeshMemoryUsage = FTerrainMemoryUsage();
+	MemoryUsage = FTerrainMemoryUsage();
+	PeakMemoryUsage = FTerrainMemoryUsage();
+	bMemoryUsageDirty = false;
 }
 
-void AFastRealtimeMarchingCubePlanet::AffectPlanetGeo(AFastRealtimeMarchingCubePlanet* PlanetRef,
-	FVector EffectLocation, float EffectRadius, bool AddTo)
+void AFastRealtimeMarchingCubePlanet::ReportMemoryUsage(FOutputDevice& Ar, bool bDetailed) const
 {
-	if (!PlanetRef)
+	MemoryUsage.Report(Ar, FString::Printf(TEXT("%s (%i chunks)"), *GetName(), ChunkBuildStates.Num()));
+	PeakMemoryUsage.Report(Ar, FString::Printf(TEXT("%s peak"), *GetName()));
+	if (bDetailed)
+	{
+		for (const TPair<TWeakObjectPtr<URealtimeMeshComponent>, FPlanetChunkBuildState>& ChunkBuildState : ChunkBuildStates)
+		{
+			const FPlanetChunkKey& ChunkKey = ChunkBuildState.Value.ChunkKey;
+			ChunkBuildState.Value.GetMemoryUsage().Report(Ar, FString::Printf(TEXT("    Chunk %s LOD %i"), *ChunkKey.Coord.ToString(), ChunkKey.LOD));
+		}
+	}
+}
+
+void AFastRealtimeMarchingCubePlanet::UpdateMemoryUsage()
+{
+	MemoryUsage = RootMeshMemoryUsage;
+	TotalTriCount = 0;
+	for (const TPair<TWeakObjectPtr<URealtimeMeshComponent>, FPlanetChunkBuildState>& ChunkBuildState : ChunkBuildStates)
+	{
+		MemoryUsage += ChunkBuildState.Value.GetMemoryUsage();
+		TotalTriCount += ChunkBuildState.Value.GetTriangleCount();
+	}
+
+	// Field storage covers the sparse scalar field, the legacy cube data & the edits layered over the field
+	MemoryUsage.FieldBytes += ScalarField.GetAllocatedSize() + CubeData.CubeDatum.GetAllocatedSize() + EditOps.GetAllocatedSize() + ChunkEditOps.GetAllocatedSize();
+	for (const FCubeData& CD : CubeData.CubeDatum)
+	{
+		MemoryUsage.FieldBytes += CD.VertexValues.GetAllocatedSize();
+	}
+	for (const TPair<FIntVector, TArray<int32>>& ChunkOps : ChunkEditOps)
+	{
+		MemoryUsage.FieldBytes += ChunkOps.Value.GetAllocatedSize();
+	}
+
+	FTerrainMemoryUsage::UpdatePeak(MemoryUsage, PeakMemoryUsage);
+	bMemoryUsageDirty = false;
+}
+
+void AFastRealtimeMarchingCubePlanet::ApplyQualityLevel(float QualityLevel)
+{
+	if (!bQualityGoverned)
+	{
+		bQualityGoverned = true;
+		UngovernedLODSplitDistanceScale = LODSplitDistanceScale;
+	}
+
+	SetLODSplitDistanceScale(FMath::Lerp(MinGovernedLODSplitDistanceScale, MaxGovernedLODSplitDistanceScale, FMath::Clamp(QualityLevel, 0.0f, 1.0f)));
+}
+
+void AFastRealtimeMarchingCubePlanet::RestoreUngovernedQuality()
+{
+	if (!bQualityGoverned)
 	{
 		return;
 	}
-	if (PlanetRef->ScalarField.Num() == 0)
+
+	bQualityGoverned = false;
+	SetLODSplitDistanceScale(UngovernedLODSplitDistanceScale);
+}
+
+void AFastRealtimeMarchingCubePlanet::SetLODSplitDistanceScale(float NewSplitDistanceScale)
+{
+	if (NewSplitDistanceScale == LODSplitDistanceScale)
+	{
+		return;
+	}
+
+	LODSplitDistanceScale = NewSplitDistanceScale;
+	if (bUseOctreeLOD && ChunkDensityRanges.Num() > 0)
+	{
+		UpdateOctree();
+	}
+}
+
+void AFastRealtimeMarchingCubePlanet::StartFlightRecording()
+{
+	FlightRecording.Emplace();
+	FlightRecording->CaptureSettings(this);
+	RecordingFrame = FTerrainFlightPathFrame();
+	RecordedEditOpCount = 0;
+}
+
+bool AFastRealtimeMarchingCubePlanet::StopFlightRecording(const FString& FilePath)
+{
+	if (!FlightRecording.IsSet())
+	{
+		return false;
+	}
+
+	const bool bSaved = FlightRecording->SaveToFile(FilePath);
+	FlightRecording.Reset();
+	return bSaved;
+}
+
+bool AFastRealtimeMarchingCubePlanet::IsGroundBuiltUnder(FVector ObserverLocation) const
+{
+	// Nothing is built until the field has been
+	if (ChunkDensityRanges.Num() == 0)
+	{
+		return false;
+	}
+
+	const FVector LocalLocation = UKismetMathLibrary::InverseTransformLocation(GetActorTransform(), ObserverLocation);
+	const FVector GroundLocation = LocalLocation.GetSafeNormal() * (SurfaceHeight * PlanetSize * 0.5f);
+
+	if (bUseOctreeLOD)
+	{
+		// Leaves with nothing to mesh are never queued, so they count as settled straight away
+		for (const FPlanetChunkKey& Leaf : OctreeLeaves)
+		{
+			if (GetChunkBounds(Leaf).IsInsideOrOn(GroundLocation))
+			{
+				return !UnsettledOctreeChunks.Contains(Leaf);
+			}
+		}
+		return false;
+	}
+
+	const FIntVector GroundChunk = ChunkCoordFromCenter(GroundLocation);
+	const FIntVector ChunkCoord = FIntVector(
+		FMath::Clamp(GroundChunk.X, 0, ComponentBreakupScale - 1),
+		FMath::Clamp(GroundChunk.Y, 0, ComponentBreakupScale - 1),
+		FMath::Clamp(GroundChunk.Z, 0, ComponentBreakupScale - 1));
+	if (!ChunkCanContainSurface(ChunkCoord))
+	{
+		return true;
+	}
+
+	URealtimeMeshComponent* MeshComp = ChunkMeshComps.FindRef(ChunkCoord);
+	const FPlanetChunkBuildState* BuildState = MeshComp ? ChunkBuildStates.Find(MeshComp) : nullptr;
+	return BuildState && !BuildState->bInFlight && !PendingTerrainChunks.Contains(ChunkCenterFromCoord(ChunkCoord));
+}
+
+void AFastRealtimeMarchingCubePlanet::UpdateObserverPosition(FVector ObserverLocation)
+{
+	if (FlightRecording.IsSet())
+	{
+		RecordingFrame.bObserverUpdated = true;
+		RecordingFrame.ObserverLocation = ObserverLocation;
+	}
+
+	ObserverLocalPosition = UKismetMathLibrary::InverseTransformLocation(GetActorTransform(), ObserverLocation);
+	if (bUseOctreeLOD)
+	{
+		UpdateOctree();
+	}
+}
+
+void AFastRealtimeMarchingCubePlanet::AffectPlanetGeo(AFastRealtimeMarchingCubePlanet* PlanetRef,
+	FVector EffectLocation, float EffectRadius, bool AddTo)
+{
+	if (!PlanetRef)
 	{
 		return;
 	}
@@ -739,81 +1048,543 @@ void AFastRealtimeMarchingCubePlanet::AffectPlanetGeo(AFastRealtimeMarchingCubeP
 	//TArray<UPrimitiveComponent*> OutComponents;
 	//UKismetSystemLibrary::SphereOverlapComponents(PlanetRef, EffectLocation, EffectRadius * 2.0f, ObjectTypes, URealtimeMeshComponent::StaticClass(), {}, OutComponents);
 
-	const float SnapSize = PlanetRef->PlanetSize / (PlanetRef->ComponentBreakupScale * PlanetRef->PerCompRes);
-	const FVector SnappedPosition = UKismetMathLibrary::Vector_SnappedToGrid(UKismetMathLibrary::InverseTransformLocation(PlanetRef->GetActorTransform(), EffectLocation), SnapSize);
-	const int32 GridCount = FMath::RoundToInt32(UKismetMathLibrary::SafeDivide(EffectRadius * 2, SnapSize));
+	FPlanetEditOp Op;
+	Op.Shape = EPlanetEditShape::Sphere;
+	Op.bAddTo = AddTo;
+	Op.A = FVector3f(UKismetMathLibrary::InverseTransformLocation(PlanetRef->GetActorTransform(), EffectLocation));
+	Op.Radius = EffectRadius;
+	PlanetRef->QueueEditOp(Op);
+}
+
+void AFastRealtimeMarchingCubePlanet::AffectPlanetGeoCapsule(AFastRealtimeMarchingCubePlanet* PlanetRef, FVector Start, FVector End,
+	float Radius, bool AddTo, float Smoothness)
+{
+	if (!PlanetRef)
+	{
+		return;
+	}
 
-	TArray<URealtimeMeshComponent*> Keys;
-	PlanetRef->GeneratedMeshComps.GetKeys(Keys);
-	TArray<URealtimeMeshComponent*> CompsToEdit;
-	for (URealtimeMeshComponent* Key : Keys)
+	FPlanetEditOp Op;
+	Op.Shape = EPlanetEditShape::Capsule;
+	Op.bAddTo = AddTo;
+	Op.A = FVector3f(UKismetMathLibrary::InverseTransformLocation(PlanetRef->GetActorTransform(), Start));
+	Op.B = FVector3f(UKismetMathLibrary::InverseTransformLocation(PlanetRef->GetActorTransform(), End));
+	Op.Radius = Radius;
+	Op.Smoothness = FMath::Max(Smoothness, 0.0f);
+	PlanetRef->QueueEditOp(Op);
+}
+
+void AFastRealtimeMarchingCubePlanet::AffectPlanetGeoBox(AFastRealtimeMarchingCubePlanet* PlanetRef, FVector Center, FRotator Rotation,
+	FVector Extent, bool AddTo, float Smoothness)
+{
+	if (!PlanetRef)
+	{
+		return;
+	}
+
+	FPlanetEditOp Op;
+	Op.Shape = EPlanetEditShape::Box;
+	Op.bAddTo = AddTo;
+	Op.A = FVector3f(UKismetMathLibrary::InverseTransformLocation(PlanetRef->GetActorTransform(), Center));
+	Op.Rotation = FQuat4f(PlanetRef->GetActorQuat().Inverse() * Rotation.Quaternion());
+	Op.Extent = FVector3f(Extent.GetAbs());
+	Op.Smoothness = FMath::Max(Smoothness, 0.0f);
+	PlanetRef->QueueEditOp(Op);
+}
+
+void AFastRealtimeMarchingCubePlanet::QueueEditOp(FPlanetEditOp Op)
+{
+	// Edits made before the planet's been generated have nothing to apply to
+	if (ScalarField.IsEmpty())
 	{
-		if ((UKismetMathLibrary::Vector_Distance(PlanetRef->GeneratedMeshComps[Key], SnappedPosition) - PlanetRef->PlanetSize / PlanetRef->ComponentBreakupScale) < EffectRadius)
+		return;
+	}
+
+	// Queue the edit, it's applied on tick along with any others made this frame
+	FPlanetEditJournal::QuantizeOp(Op, GetEditJournalQuantum());
+	PendingEditOps.Add(Op);
+}
+
+bool AFastRealtimeMarchingCubePlanet::SaveEditJournal(const FString& FilePath) const
+{
+	TArray<uint8> Journal;
+	GetEditJournalRange(0, GetEditOpCount(), Journal);
+	return FFileHelper::SaveArrayToFile(Journal, *FilePath);
+}
+
+bool AFastRealtimeMarchingCubePlanet::LoadEditJournal(const FString& FilePath)
+{
+	TArray<uint8> Journal;
+	if (!FFileHelper::LoadFileToArray(Journal, *FilePath))
+	{
+		return false;
+	}
+	return ApplyEditJournal(Journal);
+}
+
+void AFastRealtimeMarchingCubePlanet::GetEditJournalRange(int32 FirstOp, int32 MaxOps, TArray<uint8>& OutJournal) const
+{
+	OutJournal.Reset();
+
+	// Applied edits come first, followed by any still pending
+	FirstOp = FMath::Clamp(FirstOp, 0, GetEditOpCount());
+	const int32 LastOp = FMath::Min(FirstOp + FMath::Max(MaxOps, 0), GetEditOpCount());
+	TArray<FPlanetEditOp> RangeOps;
+	RangeOps.Reserve(LastOp - FirstOp);
+	for (int32 i = FirstOp; i < LastOp; i++)
+	{
+		RangeOps.Add(i < EditOps.Num() ? EditOps[i] : PendingEditOps[i - EditOps.Num()]);
+	}
+
+	FPlanetEditJournal::Encode(RangeOps, FirstOp, GetEditJournalQuantum(), OutJournal);
+}
+
+bool AFastRealtimeMarchingCubePlanet::ApplyEditJournal(const TArray<uint8>& Journal)
+{
+	if (ScalarField.IsEmpty())
+	{
+		return false;
+	}
+
+	int32 FirstOp = 0;
+	TArray<FPlanetEditOp> JournalOps;
+	if (!FPlanetEditJournal::Decode(Journal, FirstOp, JournalOps))
+	{
+		return false;
+	}
+
+	// Edits have to be replayed in order, so a journal starting past our last edit can't be applied yet
+	const int32 OpCount = GetEditOpCount();
+	if (FirstOp > OpCount)
+	{
+		return false;
+	}
+
+	for (int32 i = OpCount - FirstOp; i < JournalOps.Num(); i++)
+	{
+		QueueEditOp(JournalOps[i]);
+	}
+	return true;
+}
+
+int32 AFastRealtimeMarchingCubePlanet::GetSectionSize() const
+{
+	const int32 RequestedSize = SectionBrickSize > 0 ? FMath::Min(SectionBrickSize, PerCompRes) : PerCompRes;
+	const bool bSkirts = bUseOctreeLOD && bStitchLODSeams;
+	return FMath::Max(FMath::Min(RequestedSize, FFastRealtimeMarchingCubeMesher::GetMaxSectionSize(MesherType, TriangulationTableData, bSkirts)), 1);
+}
+
+void AFastRealtimeMarchingCubePlanet::ApplyPendingGeoEdits()
+{
+	if (PendingEditOps.Num() == 0)
+	{
+		return;
+	}
+	if (ScalarField.IsEmpty())
+	{
+		PendingEditOps.Empty();
+		return;
+	}
+
+	TERRAIN_STAGE_SCOPE(EditApply);
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+	INC_DWORD_STAT_BY(STAT_TerrainAppliedEdits, PendingEditOps.Num());
+	bMemoryUsageDirty = true;
+
+	const float SnapSize = PlanetSize / (ComponentBreakupScale * PerCompRes);
+	const int32 MaxChunkIndex = ComponentBreakupScale - 1;
+	const int32 MaxSampleIndex = ScalarField.GetSampleRes() - 1;
+
+	// Section bricks needing a remesh, per chunk or octree leaf
+	TMap<FPlanetChunkKey, TSet<FIntVector>> DirtySections;
+	const int32 SectionSize = GetSectionSize();
+
+	// Chunks also read samples from just past their sides for gradient normals, in samples at the coarsest LOD that can read them
+	const int32 SnapshotApron = FFastRealtimeMarchingCubeMesher::GetSnapshotApron(MesherType);
+	const int32 SampleApron = SnapshotApron << (bUseOctreeLOD ? OctreeMaxLOD : 0);
+
+	for (const FPlanetEditOp& Op : PendingEditOps)
+	{
+		// Every op is kept so edit indices line up with the journal, even ones that miss the field
+		const int32 OpIndex = EditOps.Add(Op);
+
+		// Sample range the op's bounds cover, skipping ops that miss the field entirely
+		const FBox3f Bounds = Op.GetBounds();
+		const FVector3f MinPosition = (Bounds.Min + (PlanetSize * 0.5f)) / SnapSize;
+		const FVector3f MaxPosition = (Bounds.Max + (PlanetSize * 0.5f)) / SnapSize;
+		const FIntVector MinSample = FIntVector(
+			FMath::Max(FMath::FloorToInt32(MinPosition.X), 0),
+			FMath::Max(FMath::FloorToInt32(MinPosition.Y), 0),
+			FMath::Max(FMath::FloorToInt32(MinPosition.Z), 0));
+		const FIntVector MaxSample = FIntVector(
+			FMath::Min(FMath::CeilToInt32(MaxPosition.X), MaxSampleIndex),
+			FMath::Min(FMath::CeilToInt32(MaxPosition.Y), MaxSampleIndex),
+			FMath::Min(FMath::CeilToInt32(MaxPosition.Z), MaxSampleIndex));
+		if (MinSample.X > MaxSample.X || MinSample.Y > MaxSample.Y || MinSample.Z > MaxSample.Z)
 		{
-			CompsToEdit.Add(Key);
+			continue;
+		}
+
+		// Samples on a chunk border belong to the chunks on both sides of it
+		const FIntVector MinChunk = FIntVector(
+			FMath::Clamp((MinSample.X - 1 - SampleApron) / PerCompRes, 0, MaxChunkIndex),
+			FMath::Clamp((MinSample.Y - 1 - SampleApron) / PerCompRes, 0, MaxChunkIndex),
+			FMath::Clamp((MinSample.Z - 1 - SampleApron) / PerCompRes, 0, MaxChunkIndex));
+		const FIntVector MaxChunk = FIntVector(
+			FMath::Clamp((MaxSample.X + SampleApron) / PerCompRes, 0, MaxChunkIndex),
+			FMath::Clamp((MaxSample.Y + SampleApron) / PerCompRes, 0, MaxChunkIndex),
+			FMath::Clamp((MaxSample.Z + SampleApron) / PerCompRes, 0, MaxChunkIndex));
+
+		for (int32 Z = MinChunk.Z; Z <= MaxChunk.Z; Z++)
+		{
+			for (int32 Y = MinChunk.Y; Y <= MaxChunk.Y; Y++)
+			{
+				for (int32 X = MinChunk.X; X <= MaxChunk.X; X++)
+				{
+					ChunkEditOps.FindOrAdd(FIntVector(X, Y, Z)).Add(OpIndex);
+
+					// Adding can only lower values & carving can only raise them, so widen the chunk's summary the way the op can
+					// move it. A chunk stays culled if the op can't carry it across the iso level, like an add inside solid ground
+					const int32 ChunkIndex = X + (Y * ComponentBreakupScale) + (Z * ComponentBreakupScale * ComponentBreakupScale);
+					if (ChunkDensityRanges.IsValidIndex(ChunkIndex))
+					{
+						FPlanetChunkDensityRange& Range = ChunkDensityRanges[ChunkIndex];
+						if (Op.bAddTo)
+						{
+							Range.Min = 0;
+						}
+						else
+						{
+							Range.Max = 255;
+						}
+					}
+
+					// Find what's meshing this chunk, either the chunk itself or the octree leaf covering it
+					FPlanetChunkKey ChunkKey = FPlanetChunkKey(FIntVector(X, Y, Z), 0);
+					if (bUseOctreeLOD)
+					{
+						bool bFoundLeaf = false;
+						for (int32 LOD = 0; LOD <= OctreeMaxLOD && !bFoundLeaf; LOD++)
+						{
+							ChunkKey = FPlanetChunkKey(FIntVector(X >> LOD, Y >> LOD, Z >> LOD), LOD);
+							bFoundLeaf = OctreeLeaves.Contains(ChunkKey);
+						}
+						if (!bFoundLeaf)
+						{
+							continue;
+						}
+					}
+
+					// A sample changes the cubes on both sides of it, & the gradient normals of the cubes either side of those. Find
+					// the section bricks holding them all
+					const int32 SampleStride = 1 << ChunkKey.LOD;
+					const FIntVector ChunkSampleOrigin = ChunkKey.Coord * (PerCompRes * SampleStride);
+					const FIntVector MinCube = FIntVector(
+						FMath::Clamp(((MinSample.X - ChunkSampleOrigin.X - 1) / SampleStride) - SnapshotApron, 0, PerCompRes - 1),
+						FMath::Clamp(((MinSample.Y - ChunkSampleOrigin.Y - 1) / SampleStride) - SnapshotApron, 0, PerCompRes - 1),
+						FMath::Clamp(((MinSample.Z - ChunkSampleOrigin.Z - 1) / SampleStride) - SnapshotApron, 0, PerCompRes - 1));
+					const FIntVector MaxCube = FIntVector(
+						FMath::Clamp(((MaxSample.X - ChunkSampleOrigin.X) / SampleStride) + SnapshotApron, 0, PerCompRes - 1),
+						FMath::Clamp(((MaxSample.Y - ChunkSampleOrigin.Y) / SampleStride) + SnapshotApron, 0, PerCompRes - 1),
+						FMath::Clamp(((MaxSample.Z - ChunkSampleOrigin.Z) / SampleStride) + SnapshotApron, 0, PerCompRes - 1));
+
+					TSet<FIntVector>& ChunkDirtySections = DirtySections.FindOrAdd(ChunkKey);
+					for (int32 SZ = MinCube.Z / SectionSize; SZ <= MaxCube.Z / SectionSize; SZ++)
+					{
+						for (int32 SY = MinCube.Y / SectionSize; SY <= MaxCube.Y / SectionSize; SY++)
+						{
+							for (int32 SX = MinCube.X / SectionSize; SX <= MaxCube.X / SectionSize; SX++)
+							{
+								ChunkDirtySections.Add(FIntVector(SX, SY, SZ));
+							}
+						}
+					}
+				}
+			}
 		}
 	}
-	
-	const FVector InitialOffsetPosition = SnappedPosition - ((GridCount * SnapSize) * 0.5f);
-	const float NewValue = AddTo ? 0.0f : 1.0f;
+	PendingEditOps.Empty();
+
+	// Rebuild each dirty chunk or octree leaf once, chunks with a comp only remesh the section bricks the edits touched & always
+	// rebuild so geometry the edits removed gets cleared
+	for (const TPair<FPlanetChunkKey, TSet<FIntVector>>& DirtyChunk : DirtySections)
+	{
+		const FPlanetChunkKey& ChunkKey = DirtyChunk.Key;
+		URealtimeMeshComponent* MeshComp = bUseOctreeLOD ? OctreeMeshComps.FindRef(ChunkKey) : ChunkMeshComps.FindRef(ChunkKey.Coord);
+		if (MeshComp)
+		{
+			LaunchChunkBuild(ChunkKey, MeshComp, true, DirtyChunk.Value.Array());
+			continue;
+		}
+
+		// Chunks that had nothing to mesh until now get built in full
+		if (bUseOctreeLOD)
+		{
+			if (NodeCanContainSurface(ChunkKey))
+			{
+				// The build below supersedes any queued one
+				PendingOctreeChunks.Remove(ChunkKey);
+				GenerateOctreeChunk(ChunkKey, false);
+			}
+		}
+		else if (ChunkCanContainSurface(ChunkKey.Coord))
+		{
+			// The build below supersedes any queued one
+			PendingTerrainChunks.RemoveAll([this, &ChunkKey](const FVector& PendingCenter) { return ChunkCoordFromCenter(PendingCenter) == ChunkKey.Coord; });
+			GenerateTerrainChunk(ChunkCenterFromCoord(ChunkKey.Coord), false);
+		}
+	}
+}
+
+FIntVector AFastRealtimeMarchingCubePlanet::ChunkCoordFromCenter(const FVector& ChunkCenter) const
+{
+	const FVector ChunkCoord = (ChunkCenter + (PlanetSize * 0.5f)) / (PlanetSize / ComponentBreakupScale) - 0.5f;
+	return FIntVector(FMath::RoundToInt32(ChunkCoord.X), FMath::RoundToInt32(ChunkCoord.Y), FMath::RoundToInt32(ChunkCoord.Z));
+}
+
+FVector AFastRealtimeMarchingCubePlanet::ChunkCenterFromCoord(const FIntVector& ChunkCoord) const
+{
+	const float StepSize = PlanetSize / ComponentBreakupScale;
+	const FVector StartingOffset = FVector(PlanetSize * -0.5f) + (StepSize * 0.5f);
+	return StartingOffset + FVector(ChunkCoord.X * StepSize, ChunkCoord.Y * StepSize, ChunkCoord.Z * StepSize);
+}
 
-	// Loop through local area of scalar points to set their values
-	for (int32 Z = 0; Z < GridCount; Z++)
+void AFastRealtimeMarchingCubePlanet::UpdateChunkDensityRanges(const FIntVector& MinChunk, const FIntVector& MaxChunk)
+{
+	for (int32 Z = MinChunk.Z; Z <= MaxChunk.Z; Z++)
 	{
-		for (int32 Y = 0; Y < GridCount; Y++)
+		for (int32 Y = MinChunk.Y; Y <= MaxChunk.Y; Y++)
 		{
-			for (int32 X = 0; X < GridCount; X++)
+			for (int32 X = MinChunk.X; X <= MaxChunk.X; X++)
 			{
-				const FVector P = InitialOffsetPosition + FVector(SnapSize * X, SnapSize * Y, SnapSize * Z);
-				if (UKismetMathLibrary::Vector_Distance(SnappedPosition, P) >= EffectRadius)
+				const int32 ChunkIndex = X + (Y * ComponentBreakupScale) + (Z * ComponentBreakupScale * ComponentBreakupScale);
+				if (!ChunkDensityRanges.IsValidIndex(ChunkIndex))
 				{
 					continue;
 				}
-				const int32 LookupIndex = PlanetRef->ScalarIndexLookupFromLocalLocation(P);
-				if (PlanetRef->ScalarField.IsValidIndex(LookupIndex))
+
+				// A chunk covers PerCompRes + 1 samples per side, sharing its border samples with its neighbours
+				const FIntVector SampleOrigin = FIntVector(X, Y, Z) * PerCompRes;
+				FPlanetChunkDensityRange& Range = ChunkDensityRanges[ChunkIndex];
+				ScalarField.GetRangeMinMax(SampleOrigin, SampleOrigin + PerCompRes, Range.Min, Range.Max);
+			}
+		}
+	}
+}
+
+bool AFastRealtimeMarchingCubePlanet::ChunkCanContainSurface(const FIntVector& ChunkCoord) const
+{
+	const int32 ChunkIndex = ChunkCoord.X + (ChunkCoord.Y * ComponentBreakupScale) + (ChunkCoord.Z * ComponentBreakupScale * ComponentBreakupScale);
+	if (!ChunkDensityRanges.IsValidIndex(ChunkIndex))
+	{
+		return true;
+	}
+	const FPlanetChunkDensityRange& Range = ChunkDensityRanges[ChunkIndex];
+	return Range.Min < FFastRealtimeMarchingCubeMesher::QuantizedIsoLevel && Range.Max >= FFastRealtimeMarchingCubeMesher::QuantizedIsoLevel;
+}
+
+FBox AFastRealtimeMarchingCubePlanet::GetChunkBounds(const FPlanetChunkKey& ChunkKey) const
+{
+	const float NodeSize = (PlanetSize / ComponentBreakupScale) * (1 << ChunkKey.LOD);
+	const FVector NodeMin = FVector(PlanetSize * -0.5f) + FVector(ChunkKey.Coord) * NodeSize;
+	return FBox(NodeMin, NodeMin + NodeSize);
+}
+
+bool AFastRealtimeMarchingCubePlanet::NodeCanContainSurface(const FPlanetChunkKey& ChunkKey) const
+{
+	if (ChunkKey.LOD == 0)
+	{
+		return ChunkCanContainSurface(ChunkKey.Coord);
+	}
+
+	// Merge the density summaries of every base chunk under this node, clipped to the chunk grid
+	const FIntVector MinChunk = ChunkKey.Coord * (1 << ChunkKey.LOD);
+	const FIntVector MaxChunk = FIntVector(
+		FMath::Min(MinChunk.X + (1 << ChunkKey.LOD), ComponentBreakupScale) - 1,
+		FMath::Min(MinChunk.Y + (1 << ChunkKey.LOD), ComponentBreakupScale) - 1,
+		FMath::Min(MinChunk.Z + (1 << ChunkKey.LOD), ComponentBreakupScale) - 1);
+
+	FPlanetChunkDensityRange NodeRange;
+	for (int32 Z = MinChunk.Z; Z <= MaxChunk.Z; Z++)
+	{
+		for (int32 Y = MinChunk.Y; Y <= MaxChunk.Y; Y++)
+		{
+			for (int32 X = MinChunk.X; X <= MaxChunk.X; X++)
+			{
+				const int32 ChunkIndex = X + (Y * ComponentBreakupScale) + (Z * ComponentBreakupScale * ComponentBreakupScale);
+				if (!ChunkDensityRanges.IsValidIndex(ChunkIndex))
 				{
-					//UE_LOG(LogTemp, Log, TEXT("Found valid index %i"), LookupIndex);
-					PlanetRef->ScalarField[LookupIndex] = NewValue;
+					return true;
 				}
-				else
+				NodeRange.Min = FMath::Min(NodeRange.Min, ChunkDensityRanges[ChunkIndex].Min);
+				NodeRange.Max = FMath::Max(NodeRange.Max, ChunkDensityRanges[ChunkIndex].Max);
+			}
+		}
+	}
+	return NodeRange.Min < FFastRealtimeMarchingCubeMesher::QuantizedIsoLevel && NodeRange.Max >= FFastRealtimeMarchingCubeMesher::QuantizedIsoLevel;
+}
+
+void AFastRealtimeMarchingCubePlanet::GatherChunkEditOps(const FPlanetChunkKey& ChunkKey, TArray<int32>& OutEditOps) const
+{
+	OutEditOps.Reset();
+	if (ChunkEditOps.Num() == 0)
+	{
+		return;
+	}
+
+	if (ChunkKey.LOD == 0)
+	{
+		if (const TArray<int32>* Ops = ChunkEditOps.Find(ChunkKey.Coord))
+		{
+			OutEditOps = *Ops;
+		}
+		return;
+	}
+
+	// Nodes above LOD 0 cover several base chunks, which can share ops
+	TSet<int32> NodeOps;
+	const int32 NodeChunkCount = 1 << ChunkKey.LOD;
+	const FIntVector MinChunk = ChunkKey.Coord * NodeChunkCount;
+	for (int32 Z = MinChunk.Z; Z < MinChunk.Z + NodeChunkCount; Z++)
+	{
+		for (int32 Y = MinChunk.Y; Y < MinChunk.Y + NodeChunkCount; Y++)
+		{
+			for (int32 X = MinChunk.X; X < MinChunk.X + NodeChunkCount; X++)
+			{
+				if (const TArray<int32>* Ops = ChunkEditOps.Find(FIntVector(X, Y, Z)))
 				{
-					//UE_LOG(LogTemp, Log, TEXT("Found non-valid index %i"), LookupIndex);
+					NodeOps.Append(*Ops);
 				}
 			}
 		}
 	}
 
-	// Tell relevant chunks to update
-	for (URealtimeMeshComponent* RMC : CompsToEdit)
+	// Ops have to be applied in the order they were made
+	OutEditOps = NodeOps.Array();
+	OutEditOps.Sort();
+}
+
+void AFastRealtimeMarchingCubePlanet::UpdateOctree()
+{
+	if (ScalarField.IsEmpty())
+	{
+		return;
+	}
+
+	TERRAIN_STAGE_SCOPE(OctreeUpdate);
+
+	// Walk down from the roots, splitting nodes near the observer
+	TSet<FPlanetChunkKey> NewLeaves;
+	const int32 RootRes = FMath::DivideAndRoundUp(ComponentBreakupScale, 1 << OctreeMaxLOD);
+	for (int32 Z = 0; Z < RootRes; Z++)
 	{
-		if (PlanetRef->GeneratedMeshComps.Contains(RMC))
+		for (int32 Y = 0; Y < RootRes; Y++)
 		{
-			PlanetRef->GenerateTerrainChunk(PlanetRef->GeneratedMeshComps[RMC], true);
+			for (int32 X = 0; X < RootRes; X++)
+			{
+				CollectOctreeLeaves(FPlanetChunkKey(FIntVector(X, Y, Z), OctreeMaxLOD), false, NewLeaves);
+			}
 		}
 	}
+
+	// Leaves that went away stay visible until every new leaf overlapping them has been built
+	for (const FPlanetChunkKey& OldLeaf : OctreeLeaves)
+	{
+		if (NewLeaves.Contains(OldLeaf))
+		{
+			continue;
+		}
+
+		PendingOctreeChunks.Remove(OldLeaf);
+		UnsettledOctreeChunks.Remove(OldLeaf);
+
+		URealtimeMeshComponent* OldMeshComp = nullptr;
+		if (OctreeMeshComps.RemoveAndCopyValue(OldLeaf, OldMeshComp) && OldMeshComp)
+		{
+			FPlanetRetiringChunk& Retiring = RetiringOctreeChunks.AddDefaulted_GetRef();
+			Retiring.MeshComp = OldMeshComp;
+			for (const FPlanetChunkKey& NewLeaf : NewLeaves)
+			{
+				if (NewLeaf.Overlaps(OldLeaf))
+				{
+					Retiring.Replacements.Add(NewLeaf);
+				}
+			}
+		}
+	}
+
+	// Queue up new leaves, skipping any that are entirely solid or entirely empty
+	for (const FPlanetChunkKey& NewLeaf : NewLeaves)
+	{
+		if (!OctreeLeaves.Contains(NewLeaf) && NodeCanContainSurface(NewLeaf))
+		{
+			PendingOctreeChunks.Add(NewLeaf);
+			UnsettledOctreeChunks.Add(NewLeaf);
+		}
+	}
+	OctreeLeaves = MoveTemp(NewLeaves);
+
+	// Build the leaves closest to the observer first
+	PendingOctreeChunks.Sort([this](const FPlanetChunkKey& A, const FPlanetChunkKey& B)
+	{
+		return GetChunkBounds(A).ComputeSquaredDistanceToPoint(ObserverLocalPosition) < GetChunkBounds(B).ComputeSquaredDistanceToPoint(ObserverLocalPosition);
+	});
 }
 
-int32 AFastRealtimeMarchingCubePlanet::BinaryFromVertices(TArray<float>& Vertices)
+void AFastRealtimeMarchingCubePlanet::CollectOctreeLeaves(const FPlanetChunkKey& ChunkKey, bool bInsideOldLeaf, TSet<FPlanetChunkKey>& OutLeaves) const
 {
+	// Nodes starting past the edge of the chunk grid only exist when ComponentBreakupScale isn't a power of 2, skip them
+	const FIntVector FirstChunk = ChunkKey.Coord * (1 << ChunkKey.LOD);
+	if (FirstChunk.X >= ComponentBreakupScale || FirstChunk.Y >= ComponentBreakupScale || FirstChunk.Z >= ComponentBreakupScale)
+	{
+		return;
+	}
+
+	// A node that isn't a leaf & isn't under one must have been split last time around, so it gets the hysteresis margin
+	const bool bWasLeaf = OctreeLeaves.Contains(ChunkKey);
+	const bool bWasSplit = !bWasLeaf && !bInsideOldLeaf && OctreeLeaves.Num() > 0;
 
-	int32 T = Vertices[0];
-	int32 P = 2;
-	for (int32 i = 1; i < 8; i++)
+	const FBox Bounds = GetChunkBounds(ChunkKey);
+	const double SplitDistance = Bounds.GetSize().X * LODSplitDistanceScale * (bWasSplit ? LODMergeHysteresis : 1.0f);
+	if (ChunkKey.LOD > 0 && Bounds.ComputeSquaredDistanceToPoint(ObserverLocalPosition) < SplitDistance * SplitDistance)
 	{
-		T += Vertices[i] * P;
-		P *= 2;
+		for (int32 i = 0; i < 8; i++)
+		{
+			const FIntVector ChildCoord = ChunkKey.Coord * 2 + FIntVector(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+			CollectOctreeLeaves(FPlanetChunkKey(ChildCoord, ChunkKey.LOD - 1), bInsideOldLeaf || bWasLeaf, OutLeaves);
+		}
+		return;
 	}
-	
-	return T;
+
+	OutLeaves.Add(ChunkKey);
 }
 
-int32 AFastRealtimeMarchingCubePlanet::ScalarIndexLookupFromLocalLocation(FVector LocalLocation) const
+void AFastRealtimeMarchingCubePlanet::RetireSettledOctreeChunks()
 {
-	const FVector NormalizedPosition = FVector(LocalLocation) + (PlanetSize * 0.5f);
-	const int32 IndexX = FMath::FloorToInt(NormalizedPosition.X / (PlanetSize / (PerCompRes * ComponentBreakupScale)));
-	const int32 IndexY = FMath::FloorToInt(NormalizedPosition.Y / (PlanetSize / (PerCompRes * ComponentBreakupScale))) * (PerCompRes * ComponentBreakupScale + 1);
-	const int32 IndexZ = FMath::FloorToInt(NormalizedPosition.Z / (PlanetSize / (PerCompRes * ComponentBreakupScale))) * (PerCompRes * ComponentBreakupScale + 1) * (PerCompRes * ComponentBreakupScale + 1);
-	return IndexX + IndexY + IndexZ;
+	URealtimeMeshSimple* NullMesh = nullptr;
+
+	for (int32 i = RetiringOctreeChunks.Num() - 1; i >= 0; i--)
+	{
+		// Keep the old comp around while any of its replacements are still waiting on a build
+		const bool bSettled = !RetiringOctreeChunks[i].Replacements.ContainsByPredicate([this](const FPlanetChunkKey& Replacement)
+		{
+			return UnsettledOctreeChunks.Contains(Replacement);
+		});
+		if (!bSettled)
+		{
+			continue;
+		}
+
+		if (URealtimeMeshComponent* MeshComp = RetiringOctreeChunks[i].MeshComp.Get())
+		{
+			GeneratedMeshComps.Remove(MeshComp);
+			ChunkBuildStates.Remove(MeshComp);
+			MeshComp->SetRealtimeMesh(NullMesh);
+			bMemoryUsageDirty = true;
+			MeshComp->DestroyComponent();
+		}
+		RetiringOctreeChunks.RemoveAtSwap(i);
+	}
 }
 
 void AFastRealtimeMarchingCubePlanet::GetTriangulationData(FTriangulationData& TriangulationData, const int32 Key)
@@ -826,18 +1597,18 @@ void AFastRealtimeMarchingCubePlanet::GetTriangulationData(FTriangulationData& T
 	}
 
 	// Validate key, if not valid try initializing triangulation table data and validate again, bail if still failing
-	if (Key - 1 > TriangulationTableData.Num() - 1 || Key - 1 < 0)
+	if (!TriangulationTableData.IsValid() || !TriangulationTableData->IsValidIndex(Key - 1))
 	{
 		if (!TriangulationTableDataInitialized)
 		{
 			InitializeTriangulationTableData();
 		}
-		if (Key - 1 > TriangulationTableData.Num() - 1 || Key - 1 < 0)
+		if (!TriangulationTableData.IsValid() || !TriangulationTableData->IsValidIndex(Key - 1))
 		{
 			return;
 		}
 	}
-	TriangulationData = TriangulationTableData[Key - 1];
+	TriangulationData = (*TriangulationTableData)[Key - 1];
 }
 
 void AFastRealtimeMarchingCubePlanet::InitializeTriangulationTableData()
@@ -848,13 +1619,15 @@ void AFastRealtimeMarchingCubePlanet::InitializeTriangulationTableData()
 		return;
 	}
 
-	// Step through row names & get their data to store in a static array for quicker(?) access
-	int32 i = 0;
+	// Step through row names & get their data to store in a flat array for quicker(?) access. This is built as a new
+	// array rather than written in place, as in-flight chunk builds may still be reading the previous one
+	TSharedRef<TArray<FTriangulationData>, ESPMode::ThreadSafe> NewTableData = MakeShared<TArray<FTriangulationData>, ESPMode::ThreadSafe>();
 	for (const FName RowName : TriangulationTable->GetRowNames())
 	{
-		TriangulationTableData[i] = *TriangulationTable->FindRow<FTriangulationData>(RowName, FString(), true);
-		i++;
+		const FTriangulationData* RowData = TriangulationTable->FindRow<FTriangulationData>(RowName, FString(), true);
+		NewTableData->Add(RowData ? *RowData : FTriangulationData());
 	}
+	TriangulationTableData = NewTableData;
 
 	// Set TriangulationTableDataInitialized flag so we don't have to do this again unnecessarily
 	TriangulationTableDataInitialized = true;
@@ -863,13 +1636,43 @@ void AFastRealtimeMarchingCubePlanet::InitializeTriangulationTableData()
 
 void AFastRealtimeMarchingCubePlanet::InitializeScalarField()
 {
-	ScalarField.Empty();
+	TERRAIN_STAGE_SCOPE(NoiseSampling);
+	LLM_SCOPE_BYTAG(FastRealtimeTerrain);
+	bMemoryUsageDirty = true;
+
 	const int32 VertCount = ComponentBreakupScale * PerCompRes;
 	const float StepSize = PlanetSize / VertCount;
 	const FVector3f InitialOffsetPosition = FVector3f(PlanetSize * -0.5f);
 
 	if (bRandomSeed) { Seed = UKismetMathLibrary::RandomInteger(2147483647); }
 
+	// Map in a snapshot from an earlier generation with the same settings if there is one, bricks page in as they're read
+	const bool bUseCache = bCacheScalarField && !bRandomSeed;
+	const uint64 CacheKey = bUseCache ? GetScalarFieldCacheKey() : 0;
+	const int32 ChunkCount = ComponentBreakupScale * ComponentBreakupScale * ComponentBreakupScale;
+	TArray<uint8> DensitySummary;
+	if (bUseCache && ScalarField.MapFromFile(GetScalarFieldCachePath(CacheKey), CacheKey, VertCount + 1, &DensitySummary))
+	{
+		// Chunk density ranges were saved with the snapshot as min/max pairs, so loading them doesn't page in every brick
+		ChunkDensityRanges.SetNum(ChunkCount);
+		if (DensitySummary.Num() == ChunkCount * 2)
+		{
+			for (int32 i = 0; i < ChunkCount; i++)
+			{
+				ChunkDensityRanges[i].Min = DensitySummary[i * 2];
+				ChunkDensityRanges[i].Max = DensitySummary[(i * 2) + 1];
+			}
+		}
+		else
+		{
+			UpdateChunkDensityRanges(FIntVector(0), FIntVector(ComponentBreakupScale - 1));
+		}
+		return;
+	}
+
+	// Start with every brick collapsed to empty space
+	ScalarField.Init(VertCount + 1, 1.0f);
+
 	const bool bUseNoise = NoiseLayers.Num() > 0;
 	TArray<UFastNoiseWrapper*> NoiseWrappers;
 	if (bUseNoise)
@@ -877,47 +1680,147 @@ void AFastRealtimeMarchingCubePlanet::InitializeScalarField()
 		UFastNoiseLayeringFunctions::InitNoiseWrappers(this, NoiseWrappers, NoiseLayers, Seed, NoiseScaleOV);
 	}
 
-	int32 i = 0;
+	// Noise can only ever move a sample this far along its radius, so anything further than this from the surface radius
+	// has a known value without evaluating noise. Values ramp from solid to empty over a sample step either side of the surface,
+	// the same falloff edits blend with, so the band that needs evaluating is that much wider
+	const float SurfaceRadius = SurfaceHeight * PlanetSize * 0.5f;
+	const float MaxNoiseDisplacement = bUseNoise ? FMath::Abs(NoiseDisplacementStrength) * NoiseAmplitudeBound : 0.0f;
+	const float SurfaceBand = MaxNoiseDisplacement + StepSize;
 
-	for (int32 Z = 0; Z < VertCount + 1; Z++)
+	// Debug drawing wants every sample visited, so only classify whole bricks when it's off
+	const bool bClassifyBricks = !DrawDebugCubeVerts;
+
+	// Quantized samples for the brick currently being generated, samples past the field edge stay empty
+	TStaticArray<uint8, FPlanetScalarField::BrickSampleCount> BrickSamples;
+
+	const int32 BrickRes = ScalarField.GetBrickRes();
+	for (int32 BrickZ = 0; BrickZ < BrickRes; BrickZ++)
 	{
-		for (int32 Y = 0; Y < VertCount + 1; Y++)
+		for (int32 BrickY = 0; BrickY < BrickRes; BrickY++)
 		{
-			for (int32 X = 0; X < VertCount + 1; X++)
+			for (int32 BrickX = 0; BrickX < BrickRes; BrickX++)
 			{
-				// Store Current Cube Position
-				FVector3f VertPosition = InitialOffsetPosition + FVector3f(StepSize * X, StepSize * Y, StepSize * Z);
-				const float NoiseValue = UFastNoiseLayeringFunctions::BlendNoises3D(FVector(VertPosition), NoiseWrappers, NoiseLayers) * NoiseDisplacementStrength;
-				const float DistanceNormalized = (VertPosition.Size() + NoiseValue) / (PlanetSize * 0.5f);
-				float VertValue = 1.0f;
-				if (DistanceNormalized < SurfaceHeight)
+				const FIntVector BrickOrigin = FIntVector(BrickX, BrickY, BrickZ) * FPlanetScalarField::BrickSize;
+
+				if (bClassifyBricks)
 				{
-					VertValue = 0.0f;
+					// Nearest & furthest radius of any sample in this brick
+					const FVector3f BoxMin = InitialOffsetPosition + FVector3f(BrickOrigin) * StepSize;
+					const FVector3f BoxMax = BoxMin + FVector3f(StepSize * (FPlanetScalarField::BrickSize - 1));
+					const FVector3f Nearest = FVector3f(FMath::Clamp(0.0f, BoxMin.X, BoxMax.X), FMath::Clamp(0.0f, BoxMin.Y, BoxMax.Y), FMath::Clamp(0.0f, BoxMin.Z, BoxMax.Z));
+					const FVector3f Furthest = FVector3f(
+						FMath::Max(FMath::Abs(BoxMin.X), FMath::Abs(BoxMax.X)),
+						FMath::Max(FMath::Abs(BoxMin.Y), FMath::Abs(BoxMax.Y)),
+						FMath::Max(FMath::Abs(BoxMin.Z), FMath::Abs(BoxMax.Z)));
+
+					// Entirely outside the surface band, the field was initialized empty so there's nothing to write
+					if (Nearest.Size() - SurfaceBand >= SurfaceRadius)
+					{
+						continue;
+					}
+
+					// Entirely inside the planet below the surface band, collapse straight to solid
+					if (Furthest.Size() + SurfaceBand <= SurfaceRadius)
+					{
+						FMemory::Memset(BrickSamples.GetData(), FPlanetScalarField::QuantizeValue(0.0f), FPlanetScalarField::BrickSampleCount);
+						ScalarField.SetBrick(FIntVector(BrickX, BrickY, BrickZ), BrickSamples.GetData());
+						continue;
+					}
 				}
 
-				ScalarField.Add(VertValue);
-				//UE_LOG(LogTemp, Log, TEXT("ScalarField Entry %i (X:%i Y%i Z%i) = %f at position %s"), i, X, Y, Z, VertValue, *VertPosition.ToString());
-				i++;
+				FMemory::Memset(BrickSamples.GetData(), FPlanetScalarField::QuantizeValue(1.0f), FPlanetScalarField::BrickSampleCount);
 
-				// Optional Debugging
-				if (DrawDebugCubeVerts)
+				int32 i = 0;
+				for (int32 LZ = 0; LZ < FPlanetScalarField::BrickSize; LZ++)
 				{
-					FColor PointColor = FColor::Black;
-					if (DistanceNormalized < SurfaceHeight)
+					for (int32 LY = 0; LY < FPlanetScalarField::BrickSize; LY++)
 					{
-						PointColor = FColor::White;
+						for (int32 LX = 0; LX < FPlanetScalarField::BrickSize; LX++, i++)
+						{
+							const FIntVector Sample = BrickOrigin + FIntVector(LX, LY, LZ);
+							if (!ScalarField.IsValidSample(Sample))
+							{
+								continue;
+							}
+
+							// Store Current Sample Position
+							FVector3f VertPosition = InitialOffsetPosition + FVector3f(StepSize * Sample.X, StepSize * Sample.Y, StepSize * Sample.Z);
+							const float VertRadius = VertPosition.Size();
+
+							// Only evaluate noise where it could actually move the sample into the surface band
+							float NoiseValue = 0.0f;
+							if (FMath::Abs(VertRadius - SurfaceRadius) <= SurfaceBand)
+							{
+								NoiseValue = UFastNoiseLayeringFunctions::BlendNoises3D(FVector(VertPosition), NoiseWrappers, NoiseLayers) * NoiseDisplacementStrength;
+							}
+							const float DistanceNormalized = (VertRadius + NoiseValue) / (PlanetSize * 0.5f);
+
+							// Signed distance to the surface, mapped so the iso level sits on it. A continuous field rather than a
+							// solid/empty one gives the mesher a gradient to take smooth normals from
+							const float VertValue = FMath::Clamp(0.5f + ((VertRadius + NoiseValue - SurfaceRadius) / (2.0f * StepSize)), 0.0f, 1.0f);
+
+							BrickSamples[i] = FPlanetScalarField::QuantizeValue(VertValue);
+
+							// Optional Debugging
+							if (DrawDebugCubeVerts)
+							{
+								FColor PointColor = FColor::Black;
+								if (DistanceNormalized < SurfaceHeight)
+								{
+									PointColor = FColor::White;
+								}
+								DrawDebugPoint(
+									GetWorld(),
+									UKismetMathLibrary::TransformLocation(GetActorTransform(), FVector(VertPosition)),
+									5.0f,
+									PointColor,
+									false,
+									5.0f
+									);
+							}
+						}
 					}
-					DrawDebugPoint(
-						GetWorld(),
-						UKismetMathLibrary::TransformLocation(GetActorTransform(), FVector(VertPosition)),
-						5.0f,
-						PointColor,
-						false,
-						5.0f
-						);
 				}
+
+				// Hand the brick over to the field, which collapses it if it came out uniform
+				ScalarField.SetBrick(FIntVector(BrickX, BrickY, BrickZ), BrickSamples.GetData());
 			}
 		}
 	}
-	//UE_LOG(LogTemp, Log, TEXT("ScalarField Initialized w/ %i entries"), ScalarField.Num());
-}
\ No newline at end of file
+
+	// Summarize every chunk's density range so we only queue chunks that can actually contain surface
+	ChunkDensityRanges.SetNum(ChunkCount);
+	UpdateChunkDensityRanges(FIntVector(0), FIntVector(ComponentBreakupScale - 1));
+
+	if (bUseCache)
+	{
+		DensitySummary.SetNumUninitialized(ChunkCount * 2);
+		for (int32 i = 0; i < ChunkCount; i++)
+		{
+			DensitySummary[i * 2] = ChunkDensityRanges[i].Min;
+			DensitySummary[(i * 2) + 1] = ChunkDensityRanges[i].Max;
+		}
+		ScalarField.SaveToFile(GetScalarFieldCachePath(CacheKey), CacheKey, DensitySummary);
+	}
+}
+
+uint64 AFastRealtimeMarchingCubePlanet::GetScalarFieldCacheKey() const
+{
+	// Every setting InitializeScalarField reads goes in here. The amplitude bound decides which samples skip noise, so it shapes
+	// the field as much as the noise itself. Noise layers are hashed through their exported text, so any setting on them
+	// invalidates the snapshot
+	FString KeyText = FString::Printf(TEXT("%u|%i|%f|%i|%i|%f|%f|%f|%f"),
+		ScalarFieldGeneratorVersion, Seed, PlanetSize, ComponentBreakupScale, PerCompRes, SurfaceHeight, NoiseScaleOV, NoiseDisplacementStrength, NoiseAmplitudeBound);
+	for (const FFN_NoiseLayerType& NoiseLayer : NoiseLayers)
+	{
+		KeyText += TEXT("|");
+		FFN_NoiseLayerType::StaticStruct()->ExportText(KeyText, &NoiseLayer, nullptr, nullptr, PPF_None, nullptr);
+	}
+	return CityHash64(reinterpret_cast<const char*>(*KeyText), KeyText.Len() * sizeof(TCHAR));
+}
+
+FString AFastRealtimeMarchingCubePlanet::GetScalarFieldCachePath(uint64 CacheKey) const
+{
+	const FString CacheDirectory = ScalarFieldCacheDirectory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("PlanetFieldCache") : ScalarFieldCacheDirectory;
+	return CacheDirectory / FString::Printf(TEXT("%016llx.field"), CacheKey);
+}
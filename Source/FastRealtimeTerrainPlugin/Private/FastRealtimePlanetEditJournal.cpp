@@ -0,0 +1,292 @@
+
+
+
+#include "FastRealtimePlanetEditJournal.h"
+
+namespace FastRealtimePlanetEditJournal
+{
+	// Per-op flag bits, the low 2 bits hold the shape
+	static constexpr uint8 ShapeMask = 0x03;
+	static constexpr uint8 AddToFlag = 0x04;
+	static constexpr uint8 SmoothnessFlag = 0x08;
+	static constexpr uint8 RotationFlag = 0x10;
+
+	static constexpr float RotationScale = 32767.0f;
+
+	static void WriteVarUInt(TArray<uint8>& Bytes, uint32 Value)
+	{
+		// 7 bits per byte, high bit set on every byte but the last
+		while (Value >= 0x80)
+		{
+			Bytes.Add(static_cast<uint8>(Value | 0x80));
+			Value >>= 7;
+		}
+		Bytes.Add(static_cast<uint8>(Value));
+	}
+
+	static void WriteVarInt(TArray<uint8>& Bytes, int32 Value)
+	{
+		// Zigzag so small negative deltas stay small
+		WriteVarUInt(Bytes, (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31));
+	}
+
+	static void WriteRaw(TArray<uint8>& Bytes, const void* Data, int32 Size)
+	{
+		Bytes.Append(static_cast<const uint8*>(Data), Size);
+	}
+
+	struct FReader
+	{
+		TConstArrayView<uint8> Bytes;
+		int32 Offset = 0;
+		bool bError = false;
+
+		uint32 ReadVarUInt()
+		{
+			uint32 Value = 0;
+			for (int32 Shift = 0; Shift < 35; Shift += 7)
+			{
+				if (Offset >= Bytes.Num())
+				{
+					bError = true;
+					return 0;
+				}
+				const uint8 Byte = Bytes[Offset++];
+				Value |= static_cast<uint32>(Byte & 0x7F) << Shift;
+				if ((Byte & 0x80) == 0)
+				{
+					return Value;
+				}
+			}
+			bError = true;
+			return 0;
+		}
+
+		int32 ReadVarInt()
+		{
+			const uint32 Value = ReadVarUInt();
+			return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1);
+		}
+
+		// Reads an unsigned value that has to fit an int32, anything larger is an error
+		int32 ReadVarUIntAsInt32()
+		{
+			const uint32 Value = ReadVarUInt();
+			if (Value > static_cast<uint32>(MAX_int32))
+			{
+				bError = true;
+				return 0;
+			}
+			return static_cast<int32>(Value);
+		}
+
+		// Reads a delta against Base, accumulated wide so a corrupt delta can't overflow. Results outside int32 are an error
+		FIntVector ReadVarIntDelta(const FIntVector& Base)
+		{
+			const int64 X = static_cast<int64>(Base.X) + ReadVarInt();
+			const int64 Y = static_cast<int64>(Base.Y) + ReadVarInt();
+			const int64 Z = static_cast<int64>(Base.Z) + ReadVarInt();
+			if (X < MIN_int32 || X > MAX_int32 || Y < MIN_int32 || Y > MAX_int32 || Z < MIN_int32 || Z > MAX_int32)
+			{
+				bError = true;
+				return Base;
+			}
+			return FIntVector(static_cast<int32>(X), static_cast<int32>(Y), static_cast<int32>(Z));
+		}
+
+		void ReadRaw(void* Data, int32 Size)
+		{
+			if (Offset + Size > Bytes.Num())
+			{
+				bError = true;
+				FMemory::Memzero(Data, Size);
+				return;
+			}
+			FMemory::Memcpy(Data, &Bytes[Offset], Size);
+			Offset += Size;
+		}
+	};
+
+	static FIntVector QuantizeVector(const FVector3f& V, float Quantum)
+	{
+		return FIntVector(FMath::RoundToInt32(V.X / Quantum), FMath::RoundToInt32(V.Y / Quantum), FMath::RoundToInt32(V.Z / Quantum));
+	}
+
+	static FVector3f DequantizeVector(const FIntVector& V, float Quantum)
+	{
+		return FVector3f(V.X * Quantum, V.Y * Quantum, V.Z * Quantum);
+	}
+
+	static int16 QuantizeRotationComponent(float Value)
+	{
+		return static_cast<int16>(FMath::RoundToInt32(FMath::Clamp(Value, -1.0f, 1.0f) * RotationScale));
+	}
+}
+
+void FPlanetEditJournal::QuantizeOp(FPlanetEditOp& Op, float Quantum)
+{
+	using namespace FastRealtimePlanetEditJournal;
+
+	// Only the values the encoder writes for this shape matter, the rest are reset so ops compare the same after a round trip
+	Op.A = DequantizeVector(QuantizeVector(Op.A, Quantum), Quantum);
+	Op.B = Op.Shape == EPlanetEditShape::Capsule ? DequantizeVector(QuantizeVector(Op.B, Quantum), Quantum) : FVector3f::ZeroVector;
+	Op.Extent = Op.Shape == EPlanetEditShape::Box ? DequantizeVector(QuantizeVector(Op.Extent, Quantum), Quantum) : FVector3f::ZeroVector;
+	Op.Radius = Op.Shape != EPlanetEditShape::Box ? FMath::Max(FMath::RoundToInt32(Op.Radius / Quantum), 0) * Quantum : 0.0f;
+	Op.Smoothness = FMath::Max(FMath::RoundToInt32(Op.Smoothness / Quantum), 0) * Quantum;
+	if (Op.Shape == EPlanetEditShape::Box)
+	{
+		Op.Rotation = FQuat4f(
+			QuantizeRotationComponent(Op.Rotation.X) / RotationScale,
+			QuantizeRotationComponent(Op.Rotation.Y) / RotationScale,
+			QuantizeRotationComponent(Op.Rotation.Z) / RotationScale,
+			QuantizeRotationComponent(Op.Rotation.W) / RotationScale);
+	}
+	else
+	{
+		Op.Rotation = FQuat4f::Identity;
+	}
+}
+
+void FPlanetEditJournal::Encode(TConstArrayView<FPlanetEditOp> Ops, int32 FirstOp, float Quantum, TArray<uint8>& OutBytes)
+{
+	using namespace FastRealtimePlanetEditJournal;
+
+	// Header
+	WriteRaw(OutBytes, &Magic, sizeof(Magic));
+	OutBytes.Add(Version);
+	WriteRaw(OutBytes, &Quantum, sizeof(Quantum));
+	WriteVarUInt(OutBytes, static_cast<uint32>(FirstOp));
+	WriteVarUInt(OutBytes, static_cast<uint32>(Ops.Num()));
+
+	FIntVector PreviousA = FIntVector::ZeroValue;
+	for (const FPlanetEditOp& Op : Ops)
+	{
+		const FIntVector QA = QuantizeVector(Op.A, Quantum);
+		const int32 QSmoothness = FMath::Max(FMath::RoundToInt32(Op.Smoothness / Quantum), 0);
+		const bool bRotated = Op.Shape == EPlanetEditShape::Box && !Op.Rotation.Equals(FQuat4f::Identity, 0.0f);
+
+		uint8 Flags = static_cast<uint8>(Op.Shape) & ShapeMask;
+		Flags |= Op.bAddTo ? AddToFlag : 0;
+		Flags |= QSmoothness > 0 ? SmoothnessFlag : 0;
+		Flags |= bRotated ? RotationFlag : 0;
+		OutBytes.Add(Flags);
+
+		// Positions are deltas against the previous op
+		WriteVarInt(OutBytes, QA.X - PreviousA.X);
+		WriteVarInt(OutBytes, QA.Y - PreviousA.Y);
+		WriteVarInt(OutBytes, QA.Z - PreviousA.Z);
+		PreviousA = QA;
+
+		if (Op.Shape == EPlanetEditShape::Box)
+		{
+			const FIntVector QExtent = QuantizeVector(Op.Extent, Quantum);
+			WriteVarUInt(OutBytes, static_cast<uint32>(FMath::Max(QExtent.X, 0)));
+			WriteVarUInt(OutBytes, static_cast<uint32>(FMath::Max(QExtent.Y, 0)));
+			WriteVarUInt(OutBytes, static_cast<uint32>(FMath::Max(QExtent.Z, 0)));
+			if (bRotated)
+			{
+				const int16 Rotation[4] = {
+					QuantizeRotationComponent(Op.Rotation.X),
+					QuantizeRotationComponent(Op.Rotation.Y),
+					QuantizeRotationComponent(Op.Rotation.Z),
+					QuantizeRotationComponent(Op.Rotation.W) };
+				WriteRaw(OutBytes, Rotation, sizeof(Rotation));
+			}
+		}
+		else
+		{
+			// Capsule ends are deltas against their start
+			if (Op.Shape == EPlanetEditShape::Capsule)
+			{
+				const FIntVector QB = QuantizeVector(Op.B, Quantum);
+				WriteVarInt(OutBytes, QB.X - QA.X);
+				WriteVarInt(OutBytes, QB.Y - QA.Y);
+				WriteVarInt(OutBytes, QB.Z - QA.Z);
+			}
+			WriteVarUInt(OutBytes, static_cast<uint32>(FMath::Max(FMath::RoundToInt32(Op.Radius / Quantum), 0)));
+		}
+
+		if (QSmoothness > 0)
+		{
+			WriteVarUInt(OutBytes, static_cast<uint32>(QSmoothness));
+		}
+	}
+}
+
+bool FPlanetEditJournal::Decode(TConstArrayView<uint8> Bytes, int32& OutFirstOp, TArray<FPlanetEditOp>& OutOps)
+{
+	using namespace FastRealtimePlanetEditJournal;
+
+	FReader Reader;
+	Reader.Bytes = Bytes;
+
+	// Header
+	uint32 FileMagic = 0;
+	uint8 FileVersion = 0;
+	float Quantum = 0.0f;
+	Reader.ReadRaw(&FileMagic, sizeof(FileMagic));
+	Reader.ReadRaw(&FileVersion, sizeof(FileVersion));
+	Reader.ReadRaw(&Quantum, sizeof(Quantum));
+	if (Reader.bError || FileMagic != Magic || FileVersion != Version || !(Quantum > 0.0f))
+	{
+		return false;
+	}
+	const int32 FirstOp = Reader.ReadVarUIntAsInt32();
+	const int32 OpCount = Reader.ReadVarUIntAsInt32();
+
+	// Every op takes at least 4 bytes, which bounds the count before reserving for it
+	if (Reader.bError || OpCount > Bytes.Num() / 4)
+	{
+		return false;
+	}
+	OutFirstOp = FirstOp;
+	OutOps.Reserve(OutOps.Num() + OpCount);
+
+	FIntVector PreviousA = FIntVector::ZeroValue;
+	for (int32 i = 0; i < OpCount && !Reader.bError; i++)
+	{
+		uint8 Flags = 0;
+		Reader.ReadRaw(&Flags, sizeof(Flags));
+		if ((Flags & ShapeMask) > static_cast<uint8>(EPlanetEditShape::Box))
+		{
+			return false;
+		}
+
+		FPlanetEditOp& Op = OutOps.AddDefaulted_GetRef();
+		Op.Shape = static_cast<EPlanetEditShape>(Flags & ShapeMask);
+		Op.bAddTo = (Flags & AddToFlag) != 0;
+
+		const FIntVector QA = Reader.ReadVarIntDelta(PreviousA);
+		Op.A = DequantizeVector(QA, Quantum);
+		PreviousA = QA;
+
+		if (Op.Shape == EPlanetEditShape::Box)
+		{
+			const int32 EX = Reader.ReadVarUIntAsInt32();
+			const int32 EY = Reader.ReadVarUIntAsInt32();
+			const int32 EZ = Reader.ReadVarUIntAsInt32();
+			Op.Extent = DequantizeVector(FIntVector(EX, EY, EZ), Quantum);
+			if (Flags & RotationFlag)
+			{
+				int16 Rotation[4] = { 0, 0, 0, 0 };
+				Reader.ReadRaw(Rotation, sizeof(Rotation));
+				Op.Rotation = FQuat4f(Rotation[0] / RotationScale, Rotation[1] / RotationScale, Rotation[2] / RotationScale, Rotation[3] / RotationScale);
+			}
+		}
+		else
+		{
+			if (Op.Shape == EPlanetEditShape::Capsule)
+			{
+				Op.B = DequantizeVector(Reader.ReadVarIntDelta(QA), Quantum);
+			}
+			Op.Radius = Reader.ReadVarUIntAsInt32() * Quantum;
+		}
+
+		if (Flags & SmoothnessFlag)
+		{
+			Op.Smoothness = Reader.ReadVarUIntAsInt32() * Quantum;
+		}
+	}
+
+	return !Reader.bError;
+}
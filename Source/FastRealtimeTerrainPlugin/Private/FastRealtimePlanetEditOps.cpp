@@ -0,0 +1,80 @@
+
+
+
+#include "FastRealtimePlanetEditOps.h"
+
+namespace FastRealtimePlanetEditOps
+{
+	// Polynomial smooth min, blends over a width of K
+	static float SmoothMin(float A, float B, float K)
+	{
+		if (K <= 0.0f)
+		{
+			return FMath::Min(A, B);
+		}
+		const float H = FMath::Max(K - FMath::Abs(A - B), 0.0f) / K;
+		return FMath::Min(A, B) - (H * H * K * 0.25f);
+	}
+
+	static float SmoothMax(float A, float B, float K)
+	{
+		return -SmoothMin(-A, -B, K);
+	}
+}
+
+float FPlanetEditOp::SignedDistance(const FVector3f& P) const
+{
+	switch (Shape)
+	{
+	case EPlanetEditShape::Capsule:
+	{
+		// Distance to the closest point on the capsule's segment
+		const FVector3f Segment = B - A;
+		const float SegmentLengthSquared = Segment.SizeSquared();
+		const float T = SegmentLengthSquared > UE_SMALL_NUMBER ? FMath::Clamp(FVector3f::DotProduct(P - A, Segment) / SegmentLengthSquared, 0.0f, 1.0f) : 0.0f;
+		return FVector3f::Distance(P, A + (Segment * T)) - Radius;
+	}
+	case EPlanetEditShape::Box:
+	{
+		// Work in the box's own space, then use the usual box distance
+		const FVector3f Local = Rotation.UnrotateVector(P - A);
+		const FVector3f Q = Local.GetAbs() - Extent;
+		const FVector3f Outside = FVector3f(FMath::Max(Q.X, 0.0f), FMath::Max(Q.Y, 0.0f), FMath::Max(Q.Z, 0.0f));
+		return Outside.Size() + FMath::Min(FMath::Max3(Q.X, Q.Y, Q.Z), 0.0f);
+	}
+	case EPlanetEditShape::Sphere:
+	default:
+		return FVector3f::Distance(P, A) - Radius;
+	}
+}
+
+FBox3f FPlanetEditOp::GetBounds() const
+{
+	FBox3f Bounds;
+	switch (Shape)
+	{
+	case EPlanetEditShape::Capsule:
+		Bounds = FBox3f(A.ComponentMin(B) - Radius, A.ComponentMax(B) + Radius);
+		break;
+	case EPlanetEditShape::Box:
+		// Bounding sphere of the box, so rotation doesn't matter
+		Bounds = FBox3f(A - Extent.Size(), A + Extent.Size());
+		break;
+	case EPlanetEditShape::Sphere:
+	default:
+		Bounds = FBox3f(A - Radius, A + Radius);
+		break;
+	}
+	return Bounds.ExpandBy(Smoothness);
+}
+
+float FPlanetEditOp::Apply(float Value, const FVector3f& P, float DensityScale) const
+{
+	using namespace FastRealtimePlanetEditOps;
+
+	// Treat the field value as a distance, so it can be blended with the shape in the same units. Solid is negative
+	const float FieldDistance = (Value - 0.5f) * 2.0f * DensityScale;
+	const float ShapeDistance = SignedDistance(P);
+	const float Distance = bAddTo ? SmoothMin(FieldDistance, ShapeDistance, Smoothness) : SmoothMax(FieldDistance, -ShapeDistance, Smoothness);
+	return FMath::Clamp(0.5f + (Distance / (2.0f * DensityScale)), 0.0f, 1.0f);
+}
@@ -0,0 +1,281 @@
+
+
+
+#include "FastRealtimePlanetScalarField.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+
+FPlanetScalarField::FPlanetScalarField() = default;
+
+FPlanetScalarField::~FPlanetScalarField()
+{
+	Empty();
+}
+
+void FPlanetScalarField::Init(int32 InSampleRes, float FillValue)
+{
+	Empty();
+
+	SampleRes = FMath::Max(InSampleRes, 0);
+	BrickRes = FMath::DivideAndRoundUp(SampleRes, BrickSize);
+
+	FBrick FillBrick;
+	FillBrick.UniformValue = QuantizeValue(FillValue);
+	Bricks.Init(FillBrick, BrickRes * BrickRes * BrickRes);
+}
+
+void FPlanetScalarField::Empty()
+{
+	SampleRes = 0;
+	BrickRes = 0;
+	Bricks.Empty();
+	Payloads.Empty();
+	PayloadCount = 0;
+
+	// The region has to go before the file it was mapped from
+	MappedPayloads = nullptr;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+uint8 FPlanetScalarField::GetQuantizedSample(const FIntVector& Sample) const
+{
+	const FBrick& Brick = Bricks[BrickIndex(FIntVector(Sample.X >> BrickSizeLog2, Sample.Y >> BrickSizeLog2, Sample.Z >> BrickSizeLog2))];
+	if (Brick.PayloadIndex == INDEX_NONE)
+	{
+		return Brick.UniformValue;
+	}
+	return GetPayload(Brick)[LocalSampleIndex(Sample)];
+}
+
+void FPlanetScalarField::SetBrick(const FIntVector& Brick, const uint8* Samples)
+{
+	FBrick& TargetBrick = Bricks[BrickIndex(Brick)];
+
+	// Check whether every sample matches the first one, if so the brick collapses to that value
+	bool bUniform = true;
+	for (int32 i = 1; i < BrickSampleCount; i++)
+	{
+		if (Samples[i] != Samples[0])
+		{
+			bUniform = false;
+			break;
+		}
+	}
+
+	if (bUniform)
+	{
+		TargetBrick.UniformValue = Samples[0];
+		TargetBrick.PayloadIndex = INDEX_NONE;
+		TargetBrick.bMapped = false;
+		return;
+	}
+
+	// The whole payload is about to be overwritten, so a mapped one can just be dropped
+	if (TargetBrick.PayloadIndex == INDEX_NONE || TargetBrick.bMapped)
+	{
+		TargetBrick.PayloadIndex = AllocatePayload();
+		TargetBrick.bMapped = false;
+	}
+	FMemory::Memcpy(&Payloads[TargetBrick.PayloadIndex * BrickSampleCount], Samples, BrickSampleCount);
+}
+
+void FPlanetScalarField::GetRangeMinMax(const FIntVector& MinSample, const FIntVector& MaxSample, uint8& OutMin, uint8& OutMax) const
+{
+	OutMin = 255;
+	OutMax = 0;
+
+	if (IsEmpty())
+	{
+		return;
+	}
+
+	// Clamp the sample range to the field
+	const FIntVector ClampedMin = FIntVector(FMath::Max(MinSample.X, 0), FMath::Max(MinSample.Y, 0), FMath::Max(MinSample.Z, 0));
+	const FIntVector ClampedMax = FIntVector(FMath::Min(MaxSample.X, SampleRes - 1), FMath::Min(MaxSample.Y, SampleRes - 1), FMath::Min(MaxSample.Z, SampleRes - 1));
+
+	// Step through every brick overlapping the range
+	for (int32 BZ = ClampedMin.Z >> BrickSizeLog2; BZ <= ClampedMax.Z >> BrickSizeLog2; BZ++)
+	{
+		for (int32 BY = ClampedMin.Y >> BrickSizeLog2; BY <= ClampedMax.Y >> BrickSizeLog2; BY++)
+		{
+			for (int32 BX = ClampedMin.X >> BrickSizeLog2; BX <= ClampedMax.X >> BrickSizeLog2; BX++)
+			{
+				const FBrick& Brick = Bricks[BrickIndex(FIntVector(BX, BY, BZ))];
+
+				// Uniform bricks only have the one value to consider
+				if (Brick.PayloadIndex == INDEX_NONE)
+				{
+					OutMin = FMath::Min(OutMin, Brick.UniformValue);
+					OutMax = FMath::Max(OutMax, Brick.UniformValue);
+					continue;
+				}
+
+				// Otherwise check the samples of this brick that fall inside the range
+				const FIntVector BrickOrigin = FIntVector(BX, BY, BZ) * BrickSize;
+				const FIntVector LocalMin = FIntVector(FMath::Max(ClampedMin.X, BrickOrigin.X), FMath::Max(ClampedMin.Y, BrickOrigin.Y), FMath::Max(ClampedMin.Z, BrickOrigin.Z));
+				const FIntVector LocalMax = FIntVector(FMath::Min(ClampedMax.X, BrickOrigin.X + BrickSize - 1), FMath::Min(ClampedMax.Y, BrickOrigin.Y + BrickSize - 1), FMath::Min(ClampedMax.Z, BrickOrigin.Z + BrickSize - 1));
+				const uint8* Samples = GetPayload(Brick);
+				for (int32 Z = LocalMin.Z; Z <= LocalMax.Z; Z++)
+				{
+					for (int32 Y = LocalMin.Y; Y <= LocalMax.Y; Y++)
+					{
+						for (int32 X = LocalMin.X; X <= LocalMax.X; X++)
+						{
+							const uint8 Value = Samples[LocalSampleIndex(FIntVector(X, Y, Z))];
+							OutMin = FMath::Min(OutMin, Value);
+							OutMax = FMath::Max(OutMax, Value);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+SIZE_T FPlanetScalarField::GetAllocatedSize() const
+{
+	return Bricks.GetAllocatedSize() + Payloads.GetAllocatedSize();
+}
+
+bool FPlanetScalarField::SaveToFile(const FString& FilePath, uint64 Key, TConstArrayView<uint8> Summary) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+
+	// Write to a temp file & move it into place after, so a reader never maps a half written snapshot
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+	TUniquePtr<IFileHandle> File(PlatformFile.OpenWrite(*TempFilePath));
+	if (!File.IsValid())
+	{
+		return false;
+	}
+
+	// Pack the payloads down to a contiguous run, in brick order
+	TArray<int32> PayloadIndices;
+	TArray<uint8> UniformValues;
+	PayloadIndices.SetNumUninitialized(Bricks.Num());
+	UniformValues.SetNumUninitialized(Bricks.Num());
+	int32 SavedPayloadCount = 0;
+	for (int32 i = 0; i < Bricks.Num(); i++)
+	{
+		UniformValues[i] = Bricks[i].UniformValue;
+		PayloadIndices[i] = Bricks[i].PayloadIndex == INDEX_NONE ? INDEX_NONE : SavedPayloadCount++;
+	}
+
+	// Payloads start on a page boundary so they map cleanly
+	const int64 TableEnd = sizeof(FSnapshotHeader) + PayloadIndices.Num() * sizeof(int32) + UniformValues.Num() + Summary.Num();
+	FSnapshotHeader Header;
+	Header.Magic = SnapshotMagic;
+	Header.Version = SnapshotVersion;
+	Header.Key = Key;
+	Header.SampleRes = SampleRes;
+	Header.BrickRes = BrickRes;
+	Header.PayloadCount = SavedPayloadCount;
+	Header.SummarySize = Summary.Num();
+	Header.PayloadOffset = Align(TableEnd, 4096);
+
+	bool bSuccess = File->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	bSuccess &= File->Write(reinterpret_cast<const uint8*>(PayloadIndices.GetData()), PayloadIndices.Num() * sizeof(int32));
+	bSuccess &= File->Write(UniformValues.GetData(), UniformValues.Num());
+	bSuccess &= File->Write(Summary.GetData(), Summary.Num());
+
+	TArray<uint8> Padding;
+	Padding.SetNumZeroed(Header.PayloadOffset - TableEnd);
+	bSuccess &= File->Write(Padding.GetData(), Padding.Num());
+
+	for (const FBrick& Brick : Bricks)
+	{
+		if (Brick.PayloadIndex != INDEX_NONE)
+		{
+			bSuccess &= File->Write(GetPayload(Brick), BrickSampleCount);
+		}
+	}
+	File.Reset();
+
+	if (!bSuccess)
+	{
+		PlatformFile.DeleteFile(*TempFilePath);
+		return false;
+	}
+	PlatformFile.DeleteFile(*FilePath);
+	return PlatformFile.MoveFile(*FilePath, *TempFilePath);
+}
+
+bool FPlanetScalarField::MapFromFile(const FString& FilePath, uint64 Key, int32 ExpectedSampleRes, TArray<uint8>* OutSummary)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*FilePath))
+	{
+		return false;
+	}
+
+	TUniquePtr<IMappedFileHandle> NewMappedFile(PlatformFile.OpenMapped(*FilePath));
+	if (!NewMappedFile.IsValid() || NewMappedFile->GetFileSize() < static_cast<int64>(sizeof(FSnapshotHeader)))
+	{
+		return false;
+	}
+	TUniquePtr<IMappedFileRegion> NewMappedRegion(NewMappedFile->MapRegion(0, NewMappedFile->GetFileSize()));
+	if (!NewMappedRegion.IsValid())
+	{
+		return false;
+	}
+
+	// Validate the header against what the caller expects, & make sure the file is long enough to hold what it claims to
+	const uint8* FileData = NewMappedRegion->GetMappedPtr();
+	FSnapshotHeader Header;
+	FMemory::Memcpy(&Header, FileData, sizeof(Header));
+	const int32 BrickCount = Header.BrickRes * Header.BrickRes * Header.BrickRes;
+	if (Header.Magic != SnapshotMagic || Header.Version != SnapshotVersion || Header.Key != Key || Header.SampleRes != ExpectedSampleRes
+		|| Header.BrickRes != FMath::DivideAndRoundUp(ExpectedSampleRes, BrickSize) || Header.PayloadCount < 0 || Header.SummarySize < 0
+		|| Header.PayloadOffset < static_cast<int64>(sizeof(FSnapshotHeader)) + static_cast<int64>(BrickCount) * (sizeof(int32) + 1) + Header.SummarySize
+		|| Header.PayloadOffset + static_cast<int64>(Header.PayloadCount) * BrickSampleCount > NewMappedRegion->GetMappedSize())
+	{
+		return false;
+	}
+
+	Empty();
+	SampleRes = Header.SampleRes;
+	BrickRes = Header.BrickRes;
+
+	// The brick map is small, so copy it out. Payloads stay in the mapping & page in as they're read
+	const uint8* PayloadIndices = FileData + sizeof(FSnapshotHeader);
+	const uint8* UniformValues = PayloadIndices + static_cast<int64>(BrickCount) * sizeof(int32);
+	if (OutSummary)
+	{
+		OutSummary->Reset(Header.SummarySize);
+		OutSummary->Append(UniformValues + BrickCount, Header.SummarySize);
+	}
+	Bricks.SetNum(BrickCount);
+	for (int32 i = 0; i < BrickCount; i++)
+	{
+		int32 PayloadIndex = INDEX_NONE;
+		FMemory::Memcpy(&PayloadIndex, PayloadIndices + static_cast<int64>(i) * sizeof(int32), sizeof(int32));
+
+		FBrick& Brick = Bricks[i];
+		Brick.UniformValue = UniformValues[i];
+		if (PayloadIndex >= 0 && PayloadIndex < Header.PayloadCount)
+		{
+			Brick.PayloadIndex = PayloadIndex;
+			Brick.bMapped = true;
+		}
+	}
+
+	MappedFile = MoveTemp(NewMappedFile);
+	MappedRegion = MoveTemp(NewMappedRegion);
+	MappedPayloads = FileData + Header.PayloadOffset;
+	return true;
+}
+
+int32 FPlanetScalarField::AllocatePayload()
+{
+	Payloads.AddUninitialized(BrickSampleCount);
+	return PayloadCount++;
+}
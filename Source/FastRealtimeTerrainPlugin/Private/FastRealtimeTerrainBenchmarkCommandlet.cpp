@@ -0,0 +1,398 @@
+
+
+
+#include "FastRealtimeTerrainBenchmarkCommandlet.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "FastRealtimeEndlessTerrain.h"
+#include "FastRealtimeMarchingCubePlanet.h"
+#include "FastRealtimeTerrainCommandletUtils.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+// Settings matrix every run covers, keep these stable so reports stay comparable with older baselines
+static const int32 BenchmarkTerrainResolutions[] = { 16, 64, 128 };
+static const uint8 BenchmarkLODCounts[] = { 1, 3 };
+static const float BenchmarkSmoothingAlphas[] = { 0.0f, 0.5f };
+static const int32 BenchmarkPerCompResolutions[] = { 8, 16, 32 };
+static const int32 BenchmarkComponentBreakupScales[] = { 4, 8 };
+
+// Cases run with & without vertex cache optimization. Unoptimized cases keep the names they had before it existed
+static const bool BenchmarkOptimizeVertexCache[] = { false, true };
+
+// A single measured value of a benchmark case
+struct FTerrainBenchmarkMetric
+{
+	FString Name;
+
+	double Value = 0.0;
+
+	// Whether a value above the baseline's is an improvement, as for throughput, or a regression, as for latency & memory
+	bool bHigherIsBetter = true;
+};
+
+// One endless terrain or planet configuration & what was measured building it
+struct FTerrainBenchmarkCase
+{
+	FString Name;
+
+	TSharedRef<FJsonObject> Settings = MakeShared<FJsonObject>();
+
+	TArray<FTerrainBenchmarkMetric> Metrics;
+};
+
+// Raw timings & totals gathered over every iteration of a case, turned into its metrics once the case is done
+struct FTerrainBenchmarkTimings
+{
+	// Game thread time of every tile or chunk build
+	TArray<double> BuildLatenciesMs;
+
+	double BuildSeconds = 0.0;
+
+	// Time spent producing Samples, the builds themselves when sampling is interleaved with them
+	double SampleSeconds = 0.0;
+
+	int64 Samples = 0;
+
+	int64 Vertices = 0;
+
+	int64 PeakMemoryBytes = 0;
+};
+
+static void AddTimingMetrics(FTerrainBenchmarkCase& Case, FTerrainBenchmarkTimings& Timings, const TCHAR* BuildsPerSecondName)
+{
+	Timings.BuildLatenciesMs.Sort();
+
+	const double SampleSeconds = Timings.SampleSeconds > 0.0 ? Timings.SampleSeconds : Timings.BuildSeconds;
+	Case.Metrics.Add({ TEXT("SamplesPerSecond"), SampleSeconds > 0.0 ? Timings.Samples / SampleSeconds : 0.0, true });
+	Case.Metrics.Add({ BuildsPerSecondName, Timings.BuildSeconds > 0.0 ? Timings.BuildLatenciesMs.Num() / Timings.BuildSeconds : 0.0, true });
+	Case.Metrics.Add({ TEXT("VerticesPerSecond"), Timings.BuildSeconds > 0.0 ? Timings.Vertices / Timings.BuildSeconds : 0.0, true });
+	Case.Metrics.Add({ TEXT("P50LatencyMs"), FFastRealtimeTerrainCommandletUtils::GetSortedPercentile(Timings.BuildLatenciesMs, 0.5), false });
+	Case.Metrics.Add({ TEXT("P99LatencyMs"), FFastRealtimeTerrainCommandletUtils::GetSortedPercentile(Timings.BuildLatenciesMs, 0.99), false });
+	Case.Metrics.Add({ TEXT("PeakMemoryBytes"), static_cast<double>(Timings.PeakMemoryBytes), false });
+}
+
+static FTerrainBenchmarkCase RunEndlessCase(UWorld* World, UClass* EndlessClass, int32 Seed, int32 Iterations, int32 TileGrid, int32 TerrainRes, uint8 LODCount, float SmoothingAlpha, bool bOptimizeVertexCache)
+{
+	FTerrainBenchmarkCase Case;
+	Case.Name = FString::Printf(TEXT("Endless_Res%i_LOD%i_Smooth%.2f%s"), TerrainRes, LODCount, SmoothingAlpha, bOptimizeVertexCache ? TEXT("_VCache") : TEXT(""));
+	Case.Settings->SetNumberField(TEXT("TerrainRes"), TerrainRes);
+	Case.Settings->SetNumberField(TEXT("LOD_Count"), LODCount);
+	Case.Settings->SetNumberField(TEXT("SmoothingAlpha"), SmoothingAlpha);
+	Case.Settings->SetNumberField(TEXT("TileGrid"), TileGrid);
+	Case.Settings->SetBoolField(TEXT("bOptimizeVertexCache"), bOptimizeVertexCache);
+
+	AFastRealtimeEndlessTerrain* Terrain = World->SpawnActor<AFastRealtimeEndlessTerrain>(EndlessClass, FTransform::Identity);
+	Terrain->SetActorTickEnabled(false);
+	Terrain->bUseTerrainScheduler = false;
+	Terrain->Seed = Seed;
+	Terrain->bRandomSeed = false;
+	Terrain->bLogTileTimes = false;
+	Terrain->TerrainRes = TerrainRes;
+	Terrain->LOD_Count = LODCount;
+	Terrain->SmoothingAlpha = SmoothingAlpha;
+	Terrain->bOptimizeVertexCache = bOptimizeVertexCache;
+	if (Terrain->NoiseLayers.Num() == 0)
+	{
+		Terrain->NoiseLayers.AddDefaulted();
+	}
+
+	// Tiles built before their LOD's draw order is ready skip optimizing, so have every order ready before timing any
+	Terrain->PrepareOptimizedGridOrders(true);
+
+	FTerrainBenchmarkTimings Timings;
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		Terrain->ClearTerrain();
+
+		// Build the same grid of tiles every iteration, timing each one
+		for (int32 Y = 0; Y < TileGrid; Y++)
+		{
+			for (int32 X = 0; X < TileGrid; X++)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				Terrain->GenerateTerrainTile(FVector(X * Terrain->TerrainSize, Y * Terrain->TerrainSize, 0.0f));
+				const double TileSeconds = FPlatformTime::Seconds() - StartTime;
+
+				Timings.BuildLatenciesMs.Add(TileSeconds * 1000.0);
+				Timings.BuildSeconds += TileSeconds;
+			}
+		}
+
+		Timings.Samples += Terrain->TotalNoiseSampleCount;
+		Timings.Vertices += Terrain->TotalVertCount;
+		Timings.PeakMemoryBytes = FMath::Max(Timings.PeakMemoryBytes, Terrain->PeakMemoryUsage.GetTotalBytes());
+	}
+
+	Terrain->ClearTerrain();
+	Terrain->Destroy();
+
+	AddTimingMetrics(Case, Timings, TEXT("TilesPerSecond"));
+	return Case;
+}
+
+static FTerrainBenchmarkCase RunPlanetCase(UWorld* World, UClass* PlanetClass, int32 Seed, int32 Iterations, int32 PerCompRes, int32 ComponentBreakupScale, bool bOptimizeVertexCache)
+{
+	FTerrainBenchmarkCase Case;
+	Case.Name = FString::Printf(TEXT("Planet_Res%i_Breakup%i%s"), PerCompRes, ComponentBreakupScale, bOptimizeVertexCache ? TEXT("_VCache") : TEXT(""));
+	Case.Settings->SetNumberField(TEXT("PerCompRes"), PerCompRes);
+	Case.Settings->SetNumberField(TEXT("ComponentBreakupScale"), ComponentBreakupScale);
+	Case.Settings->SetBoolField(TEXT("bOptimizeVertexCache"), bOptimizeVertexCache);
+
+	// Chunks are meshed on the game thread with no time budget, so each tick builds as few chunks as it can
+	AFastRealtimeMarchingCubePlanet* Planet = World->SpawnActor<AFastRealtimeMarchingCubePlanet>(PlanetClass, FTransform::Identity);
+	Planet->SetActorTickEnabled(false);
+	Planet->bUseTerrainScheduler = false;
+	Planet->Seed = Seed;
+	Planet->bRandomSeed = false;
+	Planet->PerCompRes = PerCompRes;
+	Planet->ComponentBreakupScale = ComponentBreakupScale;
+	Planet->bAsyncChunkBuilds = false;
+	Planet->bUseOctreeLOD = false;
+	Planet->bCacheScalarField = false;
+	Planet->bOptimizeVertexCache = bOptimizeVertexCache;
+	Planet->BuildChunkTimeBudget = 0;
+	Planet->DebugOnlyDrawOneChunk = false;
+	Planet->DrawDebugCubeEdges = false;
+	Planet->DrawDebugCubeVerts = false;
+	if (Planet->NoiseLayers.Num() == 0)
+	{
+		Planet->NoiseLayers.AddDefaulted();
+	}
+
+	const int64 FieldRes = (static_cast<int64>(ComponentBreakupScale) * PerCompRes) + 1;
+
+	FTerrainBenchmarkTimings Timings;
+	for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		// Generating the scalar field is timed on its own, as the sample throughput
+		const double FieldStartTime = FPlatformTime::Seconds();
+		Planet->GenerateMeshDeferred();
+		Timings.SampleSeconds += FPlatformTime::Seconds() - FieldStartTime;
+		Timings.Samples += FieldRes * FieldRes * FieldRes;
+
+		while (Planet->GetPendingChunkCount() > 0)
+		{
+			const int32 PendingChunks = Planet->GetPendingChunkCount();
+			const double StartTime = FPlatformTime::Seconds();
+			static_cast<AActor*>(Planet)->Tick(0.0f);
+			const double TickSeconds = FPlatformTime::Seconds() - StartTime;
+
+			// The budget check can let a tick through more than one quick chunk, so split its time between them
+			const int32 BuiltChunks = FMath::Max(PendingChunks - Planet->GetPendingChunkCount(), 1);
+			for (int32 i = 0; i < BuiltChunks; i++)
+			{
+				Timings.BuildLatenciesMs.Add((TickSeconds * 1000.0) / BuiltChunks);
+			}
+			Timings.BuildSeconds += TickSeconds;
+		}
+
+		Timings.Vertices += Planet->TotalVertCount;
+		Timings.PeakMemoryBytes = FMath::Max(Timings.PeakMemoryBytes, Planet->PeakMemoryUsage.GetTotalBytes());
+	}
+
+	Planet->ClearGeneratedMesh();
+	Planet->Destroy();
+
+	AddTimingMetrics(Case, Timings, TEXT("ChunksPerSecond"));
+	return Case;
+}
+
+static TSharedRef<FJsonObject> MakeCaseJson(const FTerrainBenchmarkCase& Case)
+{
+	const TSharedRef<FJsonObject> CaseJson = MakeShared<FJsonObject>();
+	CaseJson->SetStringField(TEXT("Name"), Case.Name);
+	CaseJson->SetObjectField(TEXT("Settings"), Case.Settings);
+	for (const FTerrainBenchmarkMetric& Metric : Case.Metrics)
+	{
+		CaseJson->SetNumberField(Metric.Name, Metric.Value);
+	}
+	return CaseJson;
+}
+
+// Adds each case's relative change from the baseline to its report entry, returns the number of metrics that regressed past
+// Tolerance
+static int32 CompareWithBaseline(const TArray<FTerrainBenchmarkCase>& Cases, const TArray<TSharedRef<FJsonObject>>& CaseJsons, const FJsonObject& Baseline, double Tolerance)
+{
+	TMap<FString, TSharedPtr<FJsonObject>> BaselineCases;
+	const TArray<TSharedPtr<FJsonValue>>* BaselineCaseValues = nullptr;
+	if (Baseline.TryGetArrayField(TEXT("Cases"), BaselineCaseValues))
+	{
+		for (const TSharedPtr<FJsonValue>& Value : *BaselineCaseValues)
+		{
+			const TSharedPtr<FJsonObject> BaselineCase = Value->AsObject();
+			FString Name;
+			if (BaselineCase.IsValid() && BaselineCase->TryGetStringField(TEXT("Name"), Name))
+			{
+				BaselineCases.Add(Name, BaselineCase);
+			}
+		}
+	}
+
+	int32 Regressions = 0;
+	for (int32 i = 0; i < Cases.Num(); i++)
+	{
+		const TSharedPtr<FJsonObject> BaselineCase = BaselineCases.FindRef(Cases[i].Name);
+		if (!BaselineCase.IsValid())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Terrain benchmark: %s isn't in the baseline"), *Cases[i].Name);
+			continue;
+		}
+
+		const TSharedRef<FJsonObject> Changes = MakeShared<FJsonObject>();
+		for (const FTerrainBenchmarkMetric& Metric : Cases[i].Metrics)
+		{
+			double BaselineValue = 0.0;
+			if (!BaselineCase->TryGetNumberField(Metric.Name, BaselineValue) || BaselineValue <= 0.0)
+			{
+				continue;
+			}
+
+			const double Change = (Metric.Value - BaselineValue) / BaselineValue;
+			Changes->SetNumberField(Metric.Name, Change);
+
+			if (Metric.bHigherIsBetter ? Change < -Tolerance : Change > Tolerance)
+			{
+				Regressions++;
+				UE_LOG(LogTemp, Error, TEXT("Terrain benchmark: %s %s regressed %+.1f%% (%.3f, baseline %.3f)"),
+					*Cases[i].Name, *Metric.Name, Change * 100.0, Metric.Value, BaselineValue);
+			}
+		}
+		CaseJsons[i]->SetObjectField(TEXT("BaselineChange"), Changes);
+	}
+	return Regressions;
+}
+
+UFastRealtimeTerrainBenchmarkCommandlet::UFastRealtimeTerrainBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UFastRealtimeTerrainBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/FastRealtimeTerrain.json");
+	FString BaselinePath;
+	FString EndlessClassPath;
+	FString PlanetClassPath;
+	double Tolerance = 0.1;
+	int32 Iterations = 3;
+	int32 Seed = 1337;
+	int32 TileGrid = 4;
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("EndlessClass="), EndlessClassPath);
+	FParse::Value(*Params, TEXT("PlanetClass="), PlanetClassPath);
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("TileGrid="), TileGrid);
+	Iterations = FMath::Max(Iterations, 1);
+	TileGrid = FMath::Max(TileGrid, 1);
+
+	UClass* EndlessClass = EndlessClassPath.IsEmpty() ? AFastRealtimeEndlessTerrain::StaticClass() : LoadClass<AFastRealtimeEndlessTerrain>(nullptr, *EndlessClassPath);
+	UClass* PlanetClass = PlanetClassPath.IsEmpty() ? AFastRealtimeMarchingCubePlanet::StaticClass() : LoadClass<AFastRealtimeMarchingCubePlanet>(nullptr, *PlanetClassPath);
+	if (!EndlessClass || !PlanetClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Terrain benchmark: couldn't load %s"), !EndlessClass ? *EndlessClassPath : *PlanetClassPath);
+		return 1;
+	}
+
+	// Load the baseline up front so a bad path fails before spending time on the benchmark
+	TSharedPtr<FJsonObject> Baseline;
+	if (!BaselinePath.IsEmpty())
+	{
+		FString BaselineString;
+		if (!FFileHelper::LoadFileToString(BaselineString, *BaselinePath) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineString), Baseline) || !Baseline.IsValid())
+		{
+			UE_LOG(LogTemp, Error, TEXT("Terrain benchmark: couldn't read baseline %s"), *BaselinePath);
+			return 1;
+		}
+	}
+
+	UWorld* World = FFastRealtimeTerrainCommandletUtils::CreateWorld(TEXT("TerrainBenchmark"));
+
+	TArray<FTerrainBenchmarkCase> Cases;
+	if (!FParse::Param(*Params, TEXT("SkipEndless")))
+	{
+		for (const int32 TerrainRes : BenchmarkTerrainResolutions)
+		{
+			for (const uint8 LODCount : BenchmarkLODCounts)
+			{
+				for (const float SmoothingAlpha : BenchmarkSmoothingAlphas)
+				{
+					for (const bool bOptimizeVertexCache : BenchmarkOptimizeVertexCache)
+					{
+						Cases.Add(RunEndlessCase(World, EndlessClass, Seed, Iterations, TileGrid, TerrainRes, LODCount, SmoothingAlpha, bOptimizeVertexCache));
+						UE_LOG(LogTemp, Display, TEXT("Terrain benchmark: finished %s"), *Cases.Last().Name);
+					}
+				}
+			}
+		}
+	}
+	if (!FParse::Param(*Params, TEXT("SkipPlanet")))
+	{
+		for (const int32 PerCompRes : BenchmarkPerCompResolutions)
+		{
+			for (const int32 ComponentBreakupScale : BenchmarkComponentBreakupScales)
+			{
+				for (const bool bOptimizeVertexCache : BenchmarkOptimizeVertexCache)
+				{
+					Cases.Add(RunPlanetCase(World, PlanetClass, Seed, Iterations, PerCompRes, ComponentBreakupScale, bOptimizeVertexCache));
+					UE_LOG(LogTemp, Display, TEXT("Terrain benchmark: finished %s"), *Cases.Last().Name);
+				}
+			}
+		}
+	}
+
+	FFastRealtimeTerrainCommandletUtils::DestroyWorld(World);
+
+	// Write the report
+	TArray<TSharedRef<FJsonObject>> CaseJsons;
+	TArray<TSharedPtr<FJsonValue>> CaseValues;
+	for (const FTerrainBenchmarkCase& Case : Cases)
+	{
+		CaseJsons.Add(MakeCaseJson(Case));
+		CaseValues.Add(MakeShared<FJsonValueObject>(CaseJsons.Last()));
+	}
+
+	int32 Regressions = 0;
+	if (Baseline.IsValid())
+	{
+		Regressions = CompareWithBaseline(Cases, CaseJsons, *Baseline, Tolerance);
+	}
+
+	const TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("Version"), 1);
+	Report->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+	Report->SetStringField(TEXT("CPU"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+	Report->SetStringField(TEXT("BuildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	Report->SetNumberField(TEXT("Seed"), Seed);
+	Report->SetNumberField(TEXT("Iterations"), Iterations);
+	Report->SetNumberField(TEXT("PeakUsedPhysicalBytes"), static_cast<double>(FPlatformMemory::GetStats().PeakUsedPhysical));
+	Report->SetArrayField(TEXT("Cases"), CaseValues);
+	if (Baseline.IsValid())
+	{
+		Report->SetStringField(TEXT("Baseline"), BaselinePath);
+		Report->SetNumberField(TEXT("Tolerance"), Tolerance);
+		Report->SetNumberField(TEXT("Regressions"), Regressions);
+	}
+
+	FString ReportString;
+	FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&ReportString));
+	if (!FFileHelper::SaveStringToFile(ReportString, *OutputPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Terrain benchmark: couldn't write report %s"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Terrain benchmark: wrote %i cases to %s"), Cases.Num(), *OutputPath);
+
+	return Regressions > 0 ? 1 : 0;
+}
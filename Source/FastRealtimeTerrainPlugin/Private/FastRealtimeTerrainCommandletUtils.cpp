@@ -0,0 +1,32 @@
+
+
+
+#include "FastRealtimeTerrainCommandletUtils.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+double FFastRealtimeTerrainCommandletUtils::GetSortedPercentile(const TArray<double>& SortedValues, double Percentile)
+{
+	if (SortedValues.Num() == 0)
+	{
+		return 0.0;
+	}
+
+	// Nearest rank
+	const int32 Rank = FMath::CeilToInt(Percentile * SortedValues.Num()) - 1;
+	return SortedValues[FMath::Clamp(Rank, 0, SortedValues.Num() - 1)];
+}
+
+UWorld* FFastRealtimeTerrainCommandletUtils::CreateWorld(const TCHAR* WorldName)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, WorldName);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	return World;
+}
+
+void FFastRealtimeTerrainCommandletUtils::DestroyWorld(UWorld* World)
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
@@ -0,0 +1,134 @@
+
+
+
+#include "FastRealtimeTerrainFlightPath.h"
+#include "Misc/FileHelper.h"
+#include "RealtimeMeshActor.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// Fewest bytes a serialized frame can take: its delta, observer flag, a single precision location & an empty journal's count
+static constexpr int64 MinFlightPathFrameBytes = sizeof(float) + sizeof(uint32) + (3 * sizeof(float)) + sizeof(int32);
+
+static void SerializeFlightPathFrame(FArchive& Ar, FTerrainFlightPathFrame& Frame)
+{
+	Ar << Frame.DeltaSeconds;
+	Ar << Frame.bObserverUpdated;
+	Ar << Frame.ObserverLocation;
+	Ar << Frame.EditJournal;
+}
+
+static void SaveFlightPathFrames(FArchive& Ar, const TArray<FTerrainFlightPathFrame>& Frames)
+{
+	int32 FrameCount = Frames.Num();
+	Ar << FrameCount;
+
+	// Archives only write through mutable references, so each frame goes through a copy
+	for (const FTerrainFlightPathFrame& SourceFrame : Frames)
+	{
+		FTerrainFlightPathFrame Frame = SourceFrame;
+		SerializeFlightPathFrame(Ar, Frame);
+	}
+}
+
+static void LoadFlightPathFrames(FArchive& Ar, TArray<FTerrainFlightPathFrame>& Frames)
+{
+	// Bound the count by what's left of the file before allocating for it
+	int32 FrameCount = 0;
+	Ar << FrameCount;
+	if (Ar.IsError() || FrameCount < 0 || FrameCount > (Ar.TotalSize() - Ar.Tell()) / MinFlightPathFrameBytes)
+	{
+		Ar.SetError();
+		return;
+	}
+	Frames.SetNum(FrameCount);
+
+	for (FTerrainFlightPathFrame& Frame : Frames)
+	{
+		SerializeFlightPathFrame(Ar, Frame);
+		if (Ar.IsError())
+		{
+			return;
+		}
+	}
+}
+
+void FTerrainFlightPath::CaptureSettings(const AActor* Terrain)
+{
+	ActorClass = FSoftClassPath(Terrain->GetClass());
+	Settings.Empty();
+
+	for (TFieldIterator<FProperty> It(Terrain->GetClass()); It; ++It)
+	{
+		// Read only stats & anything owned by the realtime mesh actor or the engine's own actor classes aren't settings
+		if (!It->HasAnyPropertyFlags(CPF_Edit) || It->HasAnyPropertyFlags(CPF_EditConst) || ARealtimeMeshActor::StaticClass()->IsChildOf(It->GetOwnerClass()))
+		{
+			continue;
+		}
+
+		FString Value;
+		It->ExportTextItem_InContainer(Value, Terrain, nullptr, nullptr, PPF_None);
+		Settings.Add(It->GetName(), Value);
+	}
+}
+
+void FTerrainFlightPath::ApplySettings(AActor* Terrain) const
+{
+	for (const TPair<FString, FString>& Setting : Settings)
+	{
+		// Settings that have since been renamed or removed are skipped
+		if (FProperty* Property = FindFProperty<FProperty>(Terrain->GetClass(), *Setting.Key))
+		{
+			Property->ImportText_InContainer(*Setting.Value, Terrain, Terrain, PPF_None);
+		}
+	}
+}
+
+bool FTerrainFlightPath::SaveToFile(const FString& FilePath) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Ar(Bytes);
+
+	uint32 FileMagic = Magic;
+	uint8 FileVersion = Version;
+	FString ClassPath = ActorClass.ToString();
+	TMap<FString, FString> FileSettings = Settings;
+	Ar << FileMagic;
+	Ar << FileVersion;
+	Ar << ClassPath;
+	Ar << FileSettings;
+	SaveFlightPathFrames(Ar, Frames);
+
+	return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+bool FTerrainFlightPath::LoadFromFile(const FString& FilePath)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+	{
+		return false;
+	}
+	FMemoryReader Ar(Bytes);
+
+	uint32 FileMagic = 0;
+	uint8 FileVersion = 0;
+	Ar << FileMagic;
+	Ar << FileVersion;
+	if (Ar.IsError() || FileMagic != Magic || FileVersion != Version)
+	{
+		return false;
+	}
+
+	FString ClassPath;
+	Ar << ClassPath;
+	Ar << Settings;
+	LoadFlightPathFrames(Ar, Frames);
+	if (Ar.IsError())
+	{
+		return false;
+	}
+
+	ActorClass = FSoftClassPath(ClassPath);
+	return true;
+}
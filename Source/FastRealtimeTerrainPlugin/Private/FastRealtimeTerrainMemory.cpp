@@ -0,0 +1,62 @@
+
+
+
+#include "FastRealtimeTerrainMemory.h"
+#include "EngineUtils.h"
+#include "FastRealtimeEndlessTerrain.h"
+#include "FastRealtimeMarchingCubePlanet.h"
+#include "HAL/IConsoleManager.h"
+#include "RealtimeMeshSimple.h"
+
+FTerrainMemoryUsage FTerrainMemoryUsage::ForMeshSection(int32 VertexCount, int32 TriangleCount, bool bCollision)
+{
+	// Sections index with 16 bits whenever their verts fit, & so does the collision cook
+	const bool b16BitIndices = VertexCount <= MAX_uint16;
+
+	FTerrainMemoryUsage Usage;
+	Usage.VertexBytes = static_cast<int64>(VertexCount) * (sizeof(FVector3f) + sizeof(FRealtimeMeshTangentsNormalPrecision) + sizeof(FVector2DHalf) + sizeof(FColor));
+	Usage.IndexBytes = static_cast<int64>(TriangleCount) * ((b16BitIndices ? sizeof(TIndex3<uint16>) : sizeof(TIndex3<uint32>)) + sizeof(uint16));
+	if (bCollision)
+	{
+		Usage.CollisionBytes = (static_cast<int64>(VertexCount) * sizeof(FVector3f)) + (static_cast<int64>(TriangleCount) * 3 * (b16BitIndices ? sizeof(uint16) : sizeof(int32)));
+	}
+	return Usage;
+}
+
+void FTerrainMemoryUsage::UpdatePeak(const FTerrainMemoryUsage& Current, FTerrainMemoryUsage& Peak)
+{
+	if (Current.GetTotalBytes() > Peak.GetTotalBytes())
+	{
+		Peak = Current;
+	}
+}
+
+void FTerrainMemoryUsage::Report(FOutputDevice& Ar, const FString& Label) const
+{
+	Ar.Logf(TEXT("%s: %.1f KB total, %.1f KB verts, %.1f KB indices, %.1f KB collision, %.1f KB field"),
+		*Label, GetTotalBytes() / 1024.0, VertexBytes / 1024.0, IndexBytes / 1024.0, CollisionBytes / 1024.0, FieldBytes / 1024.0);
+}
+
+// Terrain.MemReport [-Detailed]
+static void ReportTerrainMemory(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+{
+	if (!World)
+	{
+		return;
+	}
+
+	const bool bDetailed = Args.Contains(TEXT("-Detailed"));
+	for (TActorIterator<AFastRealtimeEndlessTerrain> It(World); It; ++It)
+	{
+		It->ReportMemoryUsage(Ar, bDetailed);
+	}
+	for (TActorIterator<AFastRealtimeMarchingCubePlanet> It(World); It; ++It)
+	{
+		It->ReportMemoryUsage(Ar, bDetailed);
+	}
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice TerrainMemReportCommand(
+	TEXT("Terrain.MemReport"),
+	TEXT("Logs the memory held by every terrain actor in the world & the most each has held. Pass -Detailed to list every tile & chunk"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ReportTerrainMemory));
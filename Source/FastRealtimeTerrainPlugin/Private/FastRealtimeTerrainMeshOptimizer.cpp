@@ -0,0 +1,292 @@
+
+
+
+#include "FastRealtimeTerrainMeshOptimizer.h"
+#include "FastRealtimeTerrainStats.h"
+
+namespace FastRealtimeTerrainMeshOptimizer
+{
+	// Scoring constants from Forsyth's reference implementation
+	static constexpr float CacheDecayPower = 1.5f;
+	static constexpr float LastTriangleScore = 0.75f;
+	static constexpr float ValenceBoostScale = 2.0f;
+	static constexpr float ValenceBoostPower = 0.5f;
+
+	// How much a vert wants its triangles drawn next, from where it sits in the cache & how many of its triangles are left
+	static float GetVertexScore(int32 CachePosition, int32 RemainingValence)
+	{
+		// Nothing left to draw with it
+		if (RemainingValence <= 0)
+		{
+			return -1.0f;
+		}
+
+		float Score = 0.0f;
+		if (CachePosition >= 0)
+		{
+			// The last triangle's verts get a fixed score, so the next triangle doesn't always just reuse its newest edge
+			if (CachePosition < 3)
+			{
+				Score = LastTriangleScore;
+			}
+			else
+			{
+				const float Scaler = 1.0f / (FFastRealtimeTerrainMeshOptimizer::CacheSize - 3);
+				Score = FMath::Pow(1.0f - ((CachePosition - 3) * Scaler), CacheDecayPower);
+			}
+		}
+
+		// Boost verts with few triangles left, so lone triangles get drawn rather than left behind to miss the cache later
+		return Score + (ValenceBoostScale * FMath::Pow(static_cast<float>(RemainingValence), -ValenceBoostPower));
+	}
+
+	// Reorders a stream's elements so element i is the one that was at Order[i]. Streams of any other length are left alone
+	static void PermuteStream(FRealtimeMeshStream* Stream, const TArray<int32>& Order)
+	{
+		if (!Stream || Stream->Num() != Order.Num())
+		{
+			return;
+		}
+
+		const int32 Stride = Stream->GetStride();
+		const TArray<uint8> Source(Stream->GetData(), Stream->Num() * Stride);
+		uint8* Dest = Stream->GetData();
+		for (int32 i = 0; i < Order.Num(); i++)
+		{
+			FMemory::Memcpy(Dest + (i * Stride), Source.GetData() + (Order[i] * Stride), Stride);
+		}
+	}
+}
+
+void FFastRealtimeTerrainMeshOptimizer::Optimize(const TArray<uint32>& Indices, int32 VertexCount, FTerrainMeshOptimizedOrder& OutOrder)
+{
+	using namespace FastRealtimeTerrainMeshOptimizer;
+
+	TERRAIN_STAGE_SCOPE(MeshOptimize);
+
+	const int32 TriangleCount = Indices.Num() / 3;
+	OutOrder.Indices.Reset(TriangleCount * 3);
+	OutOrder.TriangleOrder.Reset(TriangleCount);
+	OutOrder.VertexOrder.Reset(VertexCount);
+
+	// Count the triangles using each vert, bailing with the original order if any index is out of range
+	TArray<int32> VertexTriangleStart;
+	VertexTriangleStart.SetNumZeroed(VertexCount + 1);
+	for (int32 i = 0; i < TriangleCount * 3; i++)
+	{
+		if (Indices[i] >= static_cast<uint32>(VertexCount))
+		{
+			OutOrder.Indices.Append(Indices.GetData(), TriangleCount * 3);
+			for (int32 t = 0; t < TriangleCount; t++)
+			{
+				OutOrder.TriangleOrder.Add(t);
+			}
+			for (int32 v = 0; v < VertexCount; v++)
+			{
+				OutOrder.VertexOrder.Add(v);
+			}
+			return;
+		}
+		VertexTriangleStart[Indices[i] + 1]++;
+	}
+	for (int32 v = 0; v < VertexCount; v++)
+	{
+		VertexTriangleStart[v + 1] += VertexTriangleStart[v];
+	}
+
+	// Triangles using each vert, the first RemainingValence of each vert's range are the ones still to draw
+	TArray<int32> RemainingValence;
+	RemainingValence.SetNumZeroed(VertexCount);
+	TArray<int32> VertexTriangles;
+	VertexTriangles.SetNumUninitialized(TriangleCount * 3);
+	for (int32 t = 0; t < TriangleCount; t++)
+	{
+		for (int32 Corner = 0; Corner < 3; Corner++)
+		{
+			const uint32 Vertex = Indices[(t * 3) + Corner];
+			VertexTriangles[VertexTriangleStart[Vertex] + RemainingValence[Vertex]++] = t;
+		}
+	}
+
+	// Score every vert as if the cache were empty
+	TArray<int32> CachePosition;
+	CachePosition.Init(INDEX_NONE, VertexCount);
+	TArray<float> VertexScore;
+	VertexScore.SetNumUninitialized(VertexCount);
+	for (int32 v = 0; v < VertexCount; v++)
+	{
+		VertexScore[v] = GetVertexScore(INDEX_NONE, RemainingValence[v]);
+	}
+
+	TArray<bool> TriangleDrawn;
+	TriangleDrawn.Init(false, TriangleCount);
+
+	// Cache holds CacheSize verts between triangles, & up to 3 more while the last triangle's corners push the oldest out
+	TArray<int32> Cache;
+	TArray<int32> NewCache;
+	Cache.Reserve(CacheSize + 3);
+	NewCache.Reserve(CacheSize + 3);
+
+	int32 BestTriangle = INDEX_NONE;
+	int32 NextUndrawn = 0;
+	for (int32 Drawn = 0; Drawn < TriangleCount; Drawn++)
+	{
+		// Nothing in the cache has triangles left, carry on from the first undrawn triangle
+		if (BestTriangle == INDEX_NONE)
+		{
+			while (TriangleDrawn[NextUndrawn])
+			{
+				NextUndrawn++;
+			}
+			BestTriangle = NextUndrawn;
+		}
+
+		const int32 Triangle = BestTriangle;
+		const uint32* Corners = &Indices[Triangle * 3];
+		TriangleDrawn[Triangle] = true;
+		OutOrder.TriangleOrder.Add(Triangle);
+
+		// Its corners go to the front of the cache & drop it from the triangles they have left to draw
+		NewCache.Reset();
+		for (int32 Corner = 0; Corner < 3; Corner++)
+		{
+			const int32 Vertex = Corners[Corner];
+			const int32 Start = VertexTriangleStart[Vertex];
+			for (int32 i = 0; i < RemainingValence[Vertex]; i++)
+			{
+				if (VertexTriangles[Start + i] == Triangle)
+				{
+					Swap(VertexTriangles[Start + i], VertexTriangles[Start + RemainingValence[Vertex] - 1]);
+					RemainingValence[Vertex]--;
+					break;
+				}
+			}
+			NewCache.AddUnique(Vertex);
+		}
+		for (const int32 Vertex : Cache)
+		{
+			if (Vertex != static_cast<int32>(Corners[0]) && Vertex != static_cast<int32>(Corners[1]) && Vertex != static_cast<int32>(Corners[2]))
+			{
+				NewCache.Add(Vertex);
+			}
+		}
+
+		// Rescore every vert the cache touched, verts pushed out the end lose their cache score
+		for (int32 i = 0; i < NewCache.Num(); i++)
+		{
+			const int32 Vertex = NewCache[i];
+			CachePosition[Vertex] = i < CacheSize ? i : INDEX_NONE;
+			VertexScore[Vertex] = GetVertexScore(CachePosition[Vertex], RemainingValence[Vertex]);
+		}
+
+		// The next triangle is the best scoring one left to draw around the cache
+		BestTriangle = INDEX_NONE;
+		float BestScore = -1.0f;
+		for (const int32 Vertex : NewCache)
+		{
+			const int32 Start = VertexTriangleStart[Vertex];
+			for (int32 i = 0; i < RemainingValence[Vertex]; i++)
+			{
+				const int32 Candidate = VertexTriangles[Start + i];
+				const uint32* CandidateCorners = &Indices[Candidate * 3];
+				const float Score = VertexScore[CandidateCorners[0]] + VertexScore[CandidateCorners[1]] + VertexScore[CandidateCorners[2]];
+				if (Score > BestScore)
+				{
+					BestScore = Score;
+					BestTriangle = Candidate;
+				}
+			}
+		}
+
+		Cache.Reset();
+		Cache.Append(NewCache.GetData(), FMath::Min(NewCache.Num(), CacheSize));
+	}
+
+	// Number verts in the order the reordered triangles first use them, verts no triangle uses go on the end
+	TArray<int32> VertexRemap;
+	VertexRemap.Init(INDEX_NONE, VertexCount);
+	for (const int32 Triangle : OutOrder.TriangleOrder)
+	{
+		for (int32 Corner = 0; Corner < 3; Corner++)
+		{
+			const uint32 Vertex = Indices[(Triangle * 3) + Corner];
+			if (VertexRemap[Vertex] == INDEX_NONE)
+			{
+				VertexRemap[Vertex] = OutOrder.VertexOrder.Add(Vertex);
+			}
+			OutOrder.Indices.Add(VertexRemap[Vertex]);
+		}
+	}
+	for (int32 v = 0; v < VertexCount; v++)
+	{
+		if (VertexRemap[v] == INDEX_NONE)
+		{
+			OutOrder.VertexOrder.Add(v);
+		}
+	}
+}
+
+void FFastRealtimeTerrainMeshOptimizer::ApplyOrder(FRealtimeMeshStreamSet& StreamSet, const FTerrainMeshOptimizedOrder& Order)
+{
+	using namespace FastRealtimeTerrainMeshOptimizer;
+
+	TERRAIN_STAGE_SCOPE(MeshOptimize);
+
+	FRealtimeMeshStream* Triangles = StreamSet.Find(FRealtimeMeshStreams::Triangles);
+	FRealtimeMeshStream* Positions = StreamSet.Find(FRealtimeMeshStreams::Position);
+	if (!Triangles || !Positions || Triangles->Num() != Order.TriangleOrder.Num() || Positions->Num() != Order.VertexOrder.Num())
+	{
+		return;
+	}
+
+	// Rewrite the triangles in their new order, at whichever index width the stream was built with
+	if (Triangles->GetStride() == sizeof(TIndex3<uint16>))
+	{
+		uint16* Dest = reinterpret_cast<uint16*>(Triangles->GetData());
+		for (int32 i = 0; i < Order.Indices.Num(); i++)
+		{
+			Dest[i] = static_cast<uint16>(Order.Indices[i]);
+		}
+	}
+	else
+	{
+		FMemory::Memcpy(Triangles->GetData(), Order.Indices.GetData(), Order.Indices.Num() * sizeof(uint32));
+	}
+
+	// Polygroups are per triangle, everything else per vert
+	PermuteStream(StreamSet.Find(FRealtimeMeshStreams::PolyGroups), Order.TriangleOrder);
+	PermuteStream(Positions, Order.VertexOrder);
+	PermuteStream(StreamSet.Find(FRealtimeMeshStreams::Tangents), Order.VertexOrder);
+	PermuteStream(StreamSet.Find(FRealtimeMeshStreams::TexCoords), Order.VertexOrder);
+	PermuteStream(StreamSet.Find(FRealtimeMeshStreams::Color), Order.VertexOrder);
+}
+
+void FFastRealtimeTerrainMeshOptimizer::OptimizeStreamSet(FRealtimeMeshStreamSet& StreamSet)
+{
+	const FRealtimeMeshStream* Triangles = StreamSet.Find(FRealtimeMeshStreams::Triangles);
+	const FRealtimeMeshStream* Positions = StreamSet.Find(FRealtimeMeshStreams::Position);
+	if (!Triangles || !Positions || Triangles->Num() == 0)
+	{
+		return;
+	}
+
+	// Read the triangles back at whichever index width they were built with
+	TArray<uint32> Indices;
+	Indices.SetNumUninitialized(Triangles->Num() * 3);
+	if (Triangles->GetStride() == sizeof(TIndex3<uint16>))
+	{
+		const uint16* Source = reinterpret_cast<const uint16*>(Triangles->GetData());
+		for (int32 i = 0; i < Indices.Num(); i++)
+		{
+			Indices[i] = Source[i];
+		}
+	}
+	else
+	{
+		FMemory::Memcpy(Indices.GetData(), Triangles->GetData(), Indices.Num() * sizeof(uint32));
+	}
+
+	FTerrainMeshOptimizedOrder Order;
+	Optimize(Indices, Positions->Num(), Order);
+	ApplyOrder(StreamSet, Order);
+}
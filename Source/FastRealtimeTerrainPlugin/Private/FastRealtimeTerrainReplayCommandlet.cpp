@@ -0,0 +1,237 @@
+
+
+
+#include "FastRealtimeTerrainReplayCommandlet.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "FastRealtimeEndlessTerrain.h"
+#include "FastRealtimeMarchingCubePlanet.h"
+#include "FastRealtimeTerrainCommandletUtils.h"
+#include "FastRealtimeTerrainFlightPath.h"
+#include "FastRealtimeTerrainSubsystem.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+UFastRealtimeTerrainReplayCommandlet::UFastRealtimeTerrainReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UFastRealtimeTerrainReplayCommandlet::Main(const FString& Params)
+{
+	FString FlightPathFile;
+	FString OutputPath;
+	FParse::Value(*Params, TEXT("FlightPath="), FlightPathFile);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	const bool bSyncBuilds = FParse::Param(*Params, TEXT("SyncBuilds"));
+	const bool bRealTime = FParse::Param(*Params, TEXT("RealTime"));
+	if (OutputPath.IsEmpty())
+	{
+		OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / (FPaths::GetBaseFilename(FlightPathFile) + TEXT("_Replay.json"));
+	}
+
+	FTerrainFlightPath FlightPath;
+	if (FlightPathFile.IsEmpty() || !FlightPath.LoadFromFile(FlightPathFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Terrain replay: couldn't read flight path %s"), *FlightPathFile);
+		return 1;
+	}
+
+	UClass* ActorClass = FlightPath.ActorClass.TryLoadClass<AActor>();
+	if (!ActorClass || !(ActorClass->IsChildOf<AFastRealtimeEndlessTerrain>() || ActorClass->IsChildOf<AFastRealtimeMarchingCubePlanet>()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Terrain replay: %s isn't a terrain actor class"), *FlightPath.ActorClass.ToString());
+		return 1;
+	}
+
+	UWorld* World = FFastRealtimeTerrainCommandletUtils::CreateWorld(TEXT("TerrainReplay"));
+
+	// Spawn deferred so the recorded settings are in place before construction, & tick the actor by hand
+	AActor* Terrain = World->SpawnActorDeferred<AActor>(ActorClass, FTransform::Identity);
+	FlightPath.ApplySettings(Terrain);
+	Terrain->FinishSpawning(FTransform::Identity);
+	Terrain->SetActorTickEnabled(false);
+
+	AFastRealtimeEndlessTerrain* Endless = Cast<AFastRealtimeEndlessTerrain>(Terrain);
+	UFastRealtimeTerrainSubsystem* Scheduler = World->GetSubsystem<UFastRealtimeTerrainSubsystem>();
+	AFastRealtimeMarchingCubePlanet* Planet = Cast<AFastRealtimeMarchingCubePlanet>(Terrain);
+
+	double InitialGenerationMs = 0.0;
+	if (Planet)
+	{
+		Planet->bRandomSeed = false;
+		if (bSyncBuilds)
+		{
+			Planet->bAsyncChunkBuilds = false;
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		Planet->GenerateMeshDeferred();
+		InitialGenerationMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	}
+	else
+	{
+		Endless->bRandomSeed = false;
+	}
+
+	// Replay every frame, timing everything the terrain does on the game thread that frame
+	TArray<double> FrameCostsMs;
+	TArray<TSharedPtr<FJsonValue>> FrameCostValues;
+	TArray<TSharedPtr<FJsonValue>> PendingWorkValues;
+	FrameCostsMs.Reserve(FlightPath.Frames.Num());
+	int32 WorstFrame = INDEX_NONE;
+	double WorstFrameCostMs = 0.0;
+	double WorstFrameTime = 0.0;
+	int32 WorstFramePendingWork = 0;
+	int32 MaxPendingWork = 0;
+	double ReplaySeconds = 0.0;
+
+	// Ground under the observer is waited on from the first frame it's found missing until it's built
+	bool bHasObserver = false;
+	FVector ObserverLocation = FVector::ZeroVector;
+	double GroundWaitStart = -1.0;
+	TArray<double> TimesToGround;
+	double SecondsWithoutGround = 0.0;
+
+	for (int32 FrameIndex = 0; FrameIndex < FlightPath.Frames.Num(); FrameIndex++)
+	{
+		const FTerrainFlightPathFrame& Frame = FlightPath.Frames[FrameIndex];
+		const double StartTime = FPlatformTime::Seconds();
+
+		if (Frame.bObserverUpdated)
+		{
+			bHasObserver = true;
+			ObserverLocation = Frame.ObserverLocation;
+			if (Planet)
+			{
+				Planet->UpdateObserverPosition(Frame.ObserverLocation);
+			}
+			else
+			{
+				Endless->UpdateObserverPosition(Frame.ObserverLocation);
+			}
+		}
+		if (Planet && Frame.EditJournal.Num() > 0 && !Planet->ApplyEditJournal(Frame.EditJournal))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Terrain replay: frame %i has a malformed edit journal"), FrameIndex);
+		}
+		Terrain->Tick(Frame.DeltaSeconds);
+
+		// Tickables don't run in commandlets, so give the shared budget out by hand if the terrain left its work to it
+		if (Scheduler && UFastRealtimeTerrainSubsystem::IsSchedulingEnabled(World))
+		{
+			Scheduler->Tick(Frame.DeltaSeconds);
+		}
+
+		const double FrameCostMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		FrameCostsMs.Add(FrameCostMs);
+		FrameCostValues.Add(MakeShared<FJsonValueNumber>(FrameCostMs));
+
+		const int32 PendingWork = Planet ? Planet->GetPendingChunkCount() : Endless->GetPendingTileCount();
+		MaxPendingWork = FMath::Max(MaxPendingWork, PendingWork);
+		PendingWorkValues.Add(MakeShared<FJsonValueNumber>(PendingWork));
+
+		if (WorstFrame == INDEX_NONE || FrameCostMs > WorstFrameCostMs)
+		{
+			WorstFrame = FrameIndex;
+			WorstFrameCostMs = FrameCostMs;
+			WorstFrameTime = ReplaySeconds;
+			WorstFramePendingWork = PendingWork;
+		}
+
+		if (bRealTime && Frame.DeltaSeconds > FrameCostMs / 1000.0)
+		{
+			FPlatformProcess::Sleep(Frame.DeltaSeconds - (FrameCostMs / 1000.0));
+		}
+		ReplaySeconds += Frame.DeltaSeconds;
+
+		if (bHasObserver)
+		{
+			const bool bGroundBuilt = Planet ? Planet->IsGroundBuiltUnder(ObserverLocation) : Endless->IsGroundBuiltUnder(ObserverLocation);
+			if (!bGroundBuilt)
+			{
+				SecondsWithoutGround += Frame.DeltaSeconds;
+				if (GroundWaitStart < 0.0)
+				{
+					GroundWaitStart = ReplaySeconds - Frame.DeltaSeconds;
+				}
+			}
+			else if (GroundWaitStart >= 0.0)
+			{
+				TimesToGround.Add(ReplaySeconds - GroundWaitStart);
+				GroundWaitStart = -1.0;
+			}
+		}
+	}
+
+	FFastRealtimeTerrainCommandletUtils::DestroyWorld(World);
+
+	// Write the report
+	const int32 FrameCount = FrameCostsMs.Num();
+	double TotalCostMs = 0.0;
+	for (const double FrameCostMs : FrameCostsMs)
+	{
+		TotalCostMs += FrameCostMs;
+	}
+	TArray<double> SortedFrameCostsMs = FrameCostsMs;
+	SortedFrameCostsMs.Sort();
+
+	const TSharedRef<FJsonObject> FrameCost = MakeShared<FJsonObject>();
+	FrameCost->SetNumberField(TEXT("MeanMs"), FrameCount > 0 ? TotalCostMs / FrameCount : 0.0);
+	FrameCost->SetNumberField(TEXT("P50Ms"), FFastRealtimeTerrainCommandletUtils::GetSortedPercentile(SortedFrameCostsMs, 0.5));
+	FrameCost->SetNumberField(TEXT("P90Ms"), FFastRealtimeTerrainCommandletUtils::GetSortedPercentile(SortedFrameCostsMs, 0.9));
+	FrameCost->SetNumberField(TEXT("P99Ms"), FFastRealtimeTerrainCommandletUtils::GetSortedPercentile(SortedFrameCostsMs, 0.99));
+	FrameCost->SetNumberField(TEXT("MaxMs"), WorstFrameCostMs);
+
+	const TSharedRef<FJsonObject> Worst = MakeShared<FJsonObject>();
+	Worst->SetNumberField(TEXT("Frame"), WorstFrame);
+	Worst->SetNumberField(TEXT("Time"), WorstFrameTime);
+	Worst->SetNumberField(TEXT("CostMs"), WorstFrameCostMs);
+	Worst->SetNumberField(TEXT("PendingWork"), WorstFramePendingWork);
+
+	double TotalTimeToGround = 0.0;
+	double MaxTimeToGround = 0.0;
+	for (const double TimeToGround : TimesToGround)
+	{
+		TotalTimeToGround += TimeToGround;
+		MaxTimeToGround = FMath::Max(MaxTimeToGround, TimeToGround);
+	}
+	const TSharedRef<FJsonObject> Ground = MakeShared<FJsonObject>();
+	Ground->SetNumberField(TEXT("Waits"), TimesToGround.Num());
+	Ground->SetNumberField(TEXT("MeanSeconds"), TimesToGround.Num() > 0 ? TotalTimeToGround / TimesToGround.Num() : 0.0);
+	Ground->SetNumberField(TEXT("MaxSeconds"), MaxTimeToGround);
+	Ground->SetNumberField(TEXT("SecondsWithoutGround"), SecondsWithoutGround);
+	Ground->SetBoolField(TEXT("GroundBuiltAtEnd"), GroundWaitStart < 0.0);
+
+	const TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("Version"), 1);
+	Report->SetStringField(TEXT("FlightPath"), FlightPathFile);
+	Report->SetStringField(TEXT("ActorClass"), FlightPath.ActorClass.ToString());
+	Report->SetBoolField(TEXT("SyncBuilds"), bSyncBuilds);
+	Report->SetBoolField(TEXT("RealTime"), bRealTime);
+	Report->SetNumberField(TEXT("Frames"), FrameCount);
+	Report->SetNumberField(TEXT("ReplaySeconds"), ReplaySeconds);
+	Report->SetNumberField(TEXT("InitialGenerationMs"), InitialGenerationMs);
+	Report->SetObjectField(TEXT("FrameCost"), FrameCost);
+	Report->SetObjectField(TEXT("WorstFrame"), Worst);
+	Report->SetNumberField(TEXT("MaxPendingWork"), MaxPendingWork);
+	Report->SetObjectField(TEXT("TimeToGround"), Ground);
+	Report->SetArrayField(TEXT("FrameCostsMs"), FrameCostValues);
+	Report->SetArrayField(TEXT("PendingWork"), PendingWorkValues);
+
+	FString ReportString;
+	FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&ReportString));
+	if (!FFileHelper::SaveStringToFile(ReportString, *OutputPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Terrain replay: couldn't write report %s"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Terrain replay: %i frames, worst frame %i at %.2f ms, report written to %s"), FrameCount, WorstFrame, WorstFrameCostMs, *OutputPath);
+
+	return 0;
+}
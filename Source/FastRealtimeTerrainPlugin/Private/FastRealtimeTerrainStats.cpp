@@ -0,0 +1,38 @@
+
+
+
+#include "FastRealtimeTerrainStats.h"
+
+LLM_DEFINE_TAG(FastRealtimeTerrain);
+
+UE_TRACE_CHANNEL_DEFINE(FastRealtimeTerrainChannel);
+
+DEFINE_STAT(STAT_TerrainTick);
+DEFINE_STAT(STAT_TerrainSchedule);
+DEFINE_STAT(STAT_TerrainTileBuild);
+DEFINE_STAT(STAT_TerrainNoiseSampling);
+DEFINE_STAT(STAT_TerrainFarFieldBuild);
+DEFINE_STAT(STAT_TerrainEditApply);
+DEFINE_STAT(STAT_TerrainOctreeUpdate);
+DEFINE_STAT(STAT_TerrainChunkSnapshot);
+DEFINE_STAT(STAT_TerrainSectionCommit);
+DEFINE_STAT(STAT_TerrainCollisionUpdate);
+
+DEFINE_STAT(STAT_TerrainChunkBuild);
+DEFINE_STAT(STAT_TerrainClassification);
+DEFINE_STAT(STAT_TerrainStreamBuild);
+DEFINE_STAT(STAT_TerrainIndexBuild);
+DEFINE_STAT(STAT_TerrainSkirts);
+DEFINE_STAT(STAT_TerrainMeshOptimize);
+
+DEFINE_STAT(STAT_TerrainTileNoiseSampling);
+DEFINE_STAT(STAT_TerrainTileSmoothing);
+DEFINE_STAT(STAT_TerrainTileNormals);
+
+DEFINE_STAT(STAT_TerrainPendingTiles);
+DEFINE_STAT(STAT_TerrainPendingChunks);
+DEFINE_STAT(STAT_TerrainInFlightBuilds);
+DEFINE_STAT(STAT_TerrainAppliedEdits);
+
+DEFINE_STAT(STAT_TerrainBudget);
+DEFINE_STAT(STAT_TerrainBudgetUsed);
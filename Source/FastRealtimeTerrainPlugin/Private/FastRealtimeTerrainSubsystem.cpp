@@ -0,0 +1,323 @@
+
+
+
+#include "FastRealtimeTerrainSubsystem.h"
+#include "EngineUtils.h"
+#include "FastRealtimeEndlessTerrain.h"
+#include "FastRealtimeMarchingCubePlanet.h"
+#include "FastRealtimeTerrainStats.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+
+static TAutoConsoleVariable<bool> CVarTerrainSchedulerEnable(
+	TEXT("Terrain.Scheduler.Enable"),
+	true,
+	TEXT("Whether terrain actors with bUseTerrainScheduler set share one per-frame build budget instead of each spending their own"));
+
+static TAutoConsoleVariable<float> CVarTerrainSchedulerBudgetMs(
+	TEXT("Terrain.Scheduler.BudgetMs"),
+	4.0f,
+	TEXT("Milliseconds per frame shared between every scheduled terrain actor in a world"));
+
+static TAutoConsoleVariable<float> CVarTerrainSchedulerProximityScale(
+	TEXT("Terrain.Scheduler.ProximityScale"),
+	10000.0f,
+	TEXT("Distance from its observer at which an actor's pending work gets half the weight of work right next to it"));
+
+static TAutoConsoleVariable<bool> CVarTerrainGovernorEnable(
+	TEXT("Terrain.Governor.Enable"),
+	false,
+	TEXT("Whether the terrain build budget & quality are adjusted at runtime to hold Terrain.Governor.TargetFPS"));
+
+static TAutoConsoleVariable<float> CVarTerrainGovernorTargetFPS(
+	TEXT("Terrain.Governor.TargetFPS"),
+	60.0f,
+	TEXT("Frame rate the terrain quality governor tries to hold"));
+
+static TAutoConsoleVariable<float> CVarTerrainGovernorMinBudgetMs(
+	TEXT("Terrain.Governor.MinBudgetMs"),
+	1.0f,
+	TEXT("Least shared terrain build budget the governor will go down to, so terrain always keeps streaming in"));
+
+static TAutoConsoleVariable<float> CVarTerrainGovernorMaxBudgetMs(
+	TEXT("Terrain.Governor.MaxBudgetMs"),
+	8.0f,
+	TEXT("Most shared terrain build budget the governor will give out at full quality"));
+
+static TAutoConsoleVariable<float> CVarTerrainGovernorHysteresis(
+	TEXT("Terrain.Governor.Hysteresis"),
+	0.1f,
+	TEXT("Dead band either side of the target frame time, as a fraction of it, inside which the governor leaves quality alone"));
+
+static TAutoConsoleVariable<int32> CVarTerrainGovernorSettleFrames(
+	TEXT("Terrain.Governor.SettleFrames"),
+	30,
+	TEXT("Frames the frame time has to stay above the dead band before quality steps down, twice as many below it before it steps up"));
+
+static TAutoConsoleVariable<int32> CVarTerrainGovernorHistoryLength(
+	TEXT("Terrain.Governor.HistoryLength"),
+	600,
+	TEXT("Number of frames of governor history kept for tuning"));
+
+// Terrain.Governor.History, logs every world's governor history as CSV
+static void ReportTerrainGovernorHistory(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+{
+	const UFastRealtimeTerrainSubsystem* Subsystem = World ? World->GetSubsystem<UFastRealtimeTerrainSubsystem>() : nullptr;
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	TArray<FTerrainGovernorSample> History;
+	Subsystem->GetGovernorHistory(History);
+	Ar.Logf(TEXT("FrameMs,TerrainMs,BudgetMs,QualityLevel"));
+	for (const FTerrainGovernorSample& Sample : History)
+	{
+		Ar.Logf(TEXT("%.3f,%.3f,%.3f,%.3f"), Sample.FrameMs, Sample.TerrainMs, Sample.BudgetMs, Sample.QualityLevel);
+	}
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice TerrainGovernorHistoryCommand(
+	TEXT("Terrain.Governor.History"),
+	TEXT("Logs the frame time, terrain cost, build budget & quality level the terrain governor recorded for each recent frame as CSV"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ReportTerrainGovernorHistory));
+
+// A terrain actor with pending work this frame & its share of the budget
+struct FScheduledTerrain
+{
+	AActor* Actor = nullptr;
+
+	float Weight = 0.0f;
+};
+
+void UFastRealtimeTerrainSubsystem::Tick(float DeltaTime)
+{
+	TERRAIN_STAGE_SCOPE(Schedule);
+
+	UpdateQualityGovernor();
+
+	LastFrameUsedMs = 0.0f;
+	if (!IsSchedulingEnabled(GetWorld()))
+	{
+		StarvedFrames.Empty();
+		return;
+	}
+
+	// Gather every opted in terrain actor with work waiting, weighted by priority, proximity & how long it's been starved
+	const float ProximityScale = FMath::Max(CVarTerrainSchedulerProximityScale.GetValueOnGameThread(), 1.0f);
+	TArray<FScheduledTerrain> Scheduled;
+	auto AddScheduled = [&](AActor* Actor, float Priority, float Distance)
+	{
+		const float Weight = Priority / (1.0f + (Distance / ProximityScale));
+		Scheduled.Add({ Actor, Weight * (1 + StarvedFrames.FindRef(Actor)) });
+	};
+	for (TActorIterator<AFastRealtimeEndlessTerrain> It(GetWorld()); It; ++It)
+	{
+		if (It->bUseTerrainScheduler && It->GetPendingTileCount() > 0)
+		{
+			AddScheduled(*It, It->SchedulerPriority, It->GetPendingWorkDistance());
+		}
+	}
+	for (TActorIterator<AFastRealtimeMarchingCubePlanet> It(GetWorld()); It; ++It)
+	{
+		if (It->bUseTerrainScheduler && It->GetPendingChunkCount() > 0)
+		{
+			AddScheduled(*It, It->SchedulerPriority, It->GetPendingWorkDistance());
+		}
+	}
+
+	// Hand out the budget heaviest first, each actor getting its weight's share of whatever's left. Actors that finish early
+	// leave their unused time to the ones after them, & ones that overrun eat into it
+	Scheduled.Sort([](const FScheduledTerrain& A, const FScheduledTerrain& B) { return A.Weight > B.Weight; });
+
+	const float BudgetMs = GetFrameBudgetMs();
+	float RemainingWeight = 0.0f;
+	for (const FScheduledTerrain& Terrain : Scheduled)
+	{
+		RemainingWeight += Terrain.Weight;
+	}
+
+	TMap<TWeakObjectPtr<AActor>, int32> StillStarved;
+	for (const FScheduledTerrain& Terrain : Scheduled)
+	{
+		const float RemainingMs = BudgetMs - LastFrameUsedMs;
+		if (RemainingMs <= 0.0f || RemainingWeight <= 0.0f)
+		{
+			StillStarved.Add(Terrain.Actor, StarvedFrames.FindRef(Terrain.Actor) + 1);
+			continue;
+		}
+
+		const float SliceMs = RemainingMs * (Terrain.Weight / RemainingWeight);
+		RemainingWeight -= Terrain.Weight;
+		if (AFastRealtimeEndlessTerrain* Endless = Cast<AFastRealtimeEndlessTerrain>(Terrain.Actor))
+		{
+			LastFrameUsedMs += Endless->ProcessPendingWork(SliceMs);
+		}
+		else if (AFastRealtimeMarchingCubePlanet* Planet = Cast<AFastRealtimeMarchingCubePlanet>(Terrain.Actor))
+		{
+			LastFrameUsedMs += Planet->ProcessPendingWork(SliceMs);
+		}
+	}
+	StarvedFrames = MoveTemp(StillStarved);
+
+	INC_FLOAT_STAT_BY(STAT_TerrainBudget, BudgetMs);
+	INC_FLOAT_STAT_BY(STAT_TerrainBudgetUsed, LastFrameUsedMs);
+}
+
+TStatId UFastRealtimeTerrainSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFastRealtimeTerrainSubsystem, STATGROUP_Tickables);
+}
+
+bool UFastRealtimeTerrainSubsystem::IsSchedulingEnabled(const UWorld* World)
+{
+	return CVarTerrainSchedulerEnable.GetValueOnGameThread() && World && World->GetSubsystem<UFastRealtimeTerrainSubsystem>();
+}
+
+float UFastRealtimeTerrainSubsystem::GetFrameBudgetMs() const
+{
+	return FrameBudgetOverrideMs >= 0.0f ? FrameBudgetOverrideMs : FMath::Max(CVarTerrainSchedulerBudgetMs.GetValueOnGameThread(), 0.0f);
+}
+
+void UFastRealtimeTerrainSubsystem::GetGovernorHistory(TArray<FTerrainGovernorSample>& OutHistory) const
+{
+	OutHistory.Reset(GovernorHistory.Num());
+	for (int32 i = 0; i < GovernorHistory.Num(); i++)
+	{
+		OutHistory.Add(GovernorHistory[(GovernorHistoryHead + i) % GovernorHistory.Num()]);
+	}
+}
+
+void UFastRealtimeTerrainSubsystem::UpdateQualityGovernor()
+{
+	if (!CVarTerrainGovernorEnable.GetValueOnGameThread())
+	{
+		// Hand the budget back & put every governed setting back the way the actor had it
+		if (bGovernorActive)
+		{
+			bGovernorActive = false;
+			SetFrameBudgetMs(-1.0f);
+			QualityLevel = 1.0f;
+			RestoreUngovernedQuality();
+		}
+		return;
+	}
+
+	// Time since the last update, the engine's frame time stands in for the first one
+	const double NowSeconds = FPlatformTime::Seconds();
+	const float FrameMs = bGovernorActive ? static_cast<float>((NowSeconds - LastGovernorUpdateSeconds) * 1000.0) : FApp::GetDeltaTime() * 1000.0f;
+	LastGovernorUpdateSeconds = NowSeconds;
+
+	// Start from full quality so the first step is only ever taken once the frame time has been measured for a while
+	if (!bGovernorActive)
+	{
+		bGovernorActive = true;
+		QualityLevel = 1.0f;
+		SmoothedFrameMs = FrameMs;
+		SmoothedTerrainMs = LastFrameUsedMs;
+		FramesOverTarget = 0;
+		FramesUnderTarget = 0;
+	}
+
+	// The governor is after sustained load, single frame hitches are smoothed out
+	const float TargetMs = 1000.0f / FMath::Max(CVarTerrainGovernorTargetFPS.GetValueOnGameThread(), 1.0f);
+	SmoothedFrameMs = FMath::Lerp(SmoothedFrameMs, FrameMs, 0.1f);
+	SmoothedTerrainMs = FMath::Lerp(SmoothedTerrainMs, LastFrameUsedMs, 0.1f);
+
+	// Quality only steps once the frame time has sat outside the dead band for a while, & comes back up slower than it drops
+	const float DeadBandMs = TargetMs * FMath::Max(CVarTerrainGovernorHysteresis.GetValueOnGameThread(), 0.0f);
+	const int32 SettleFrames = FMath::Max(CVarTerrainGovernorSettleFrames.GetValueOnGameThread(), 1);
+	FramesOverTarget = SmoothedFrameMs > TargetMs + DeadBandMs ? FramesOverTarget + 1 : 0;
+	FramesUnderTarget = SmoothedFrameMs < TargetMs - DeadBandMs ? FramesUnderTarget + 1 : 0;
+	if (FramesOverTarget >= SettleFrames && QualityLevel > 0.0f)
+	{
+		QualityLevel = FMath::Max(QualityLevel - 0.1f, 0.0f);
+		FramesOverTarget = 0;
+	}
+	else if (FramesUnderTarget >= SettleFrames * 2 && QualityLevel < 1.0f)
+	{
+		QualityLevel = FMath::Min(QualityLevel + 0.05f, 1.0f);
+		FramesUnderTarget = 0;
+	}
+
+	// Pushed every frame rather than only on a step, so actors that opt in or out of the governor follow it straight away
+	ApplyQualityLevel();
+
+	// The budget follows whatever frame time is left once everything but terrain work is paid for, capped lower as quality
+	// drops, & only moves once it's a dead band away from where it is
+	const float MinBudgetMs = FMath::Max(CVarTerrainGovernorMinBudgetMs.GetValueOnGameThread(), 0.0f);
+	const float MaxBudgetMs = FMath::Lerp(MinBudgetMs, FMath::Max(CVarTerrainGovernorMaxBudgetMs.GetValueOnGameThread(), MinBudgetMs), QualityLevel);
+	const float DesiredBudgetMs = FMath::Clamp(TargetMs - (SmoothedFrameMs - SmoothedTerrainMs), MinBudgetMs, MaxBudgetMs);
+	if (FMath::Abs(DesiredBudgetMs - GetFrameBudgetMs()) > DeadBandMs || GetFrameBudgetMs() > MaxBudgetMs)
+	{
+		SetFrameBudgetMs(DesiredBudgetMs);
+	}
+
+	// Record the frame
+	FTerrainGovernorSample Sample;
+	Sample.FrameMs = FrameMs;
+	Sample.TerrainMs = LastFrameUsedMs;
+	Sample.BudgetMs = GetFrameBudgetMs();
+	Sample.QualityLevel = QualityLevel;
+
+	const int32 HistoryLength = FMath::Max(CVarTerrainGovernorHistoryLength.GetValueOnGameThread(), 1);
+	if (GovernorHistory.Num() != HistoryLength && GovernorHistoryHead != 0)
+	{
+		// The length changed after the buffer wrapped, unroll it so the oldest frames are the ones dropped
+		TArray<FTerrainGovernorSample> History;
+		GetGovernorHistory(History);
+		GovernorHistory = MoveTemp(History);
+		GovernorHistoryHead = 0;
+	}
+	if (GovernorHistory.Num() > HistoryLength)
+	{
+		GovernorHistory.RemoveAt(0, GovernorHistory.Num() - HistoryLength);
+	}
+	if (GovernorHistory.Num() < HistoryLength)
+	{
+		GovernorHistory.Add(Sample);
+	}
+	else
+	{
+		GovernorHistory[GovernorHistoryHead] = Sample;
+		GovernorHistoryHead = (GovernorHistoryHead + 1) % HistoryLength;
+	}
+}
+
+void UFastRealtimeTerrainSubsystem::ApplyQualityLevel()
+{
+	for (TActorIterator<AFastRealtimeEndlessTerrain> It(GetWorld()); It; ++It)
+	{
+		if (It->bAllowQualityGovernor)
+		{
+			It->ApplyQualityLevel(QualityLevel);
+		}
+		else
+		{
+			It->RestoreUngovernedQuality();
+		}
+	}
+	for (TActorIterator<AFastRealtimeMarchingCubePlanet> It(GetWorld()); It; ++It)
+	{
+		if (It->bAllowQualityGovernor)
+		{
+			It->ApplyQualityLevel(QualityLevel);
+		}
+		else
+		{
+			It->RestoreUngovernedQuality();
+		}
+	}
+}
+
+void UFastRealtimeTerrainSubsystem::RestoreUngovernedQuality()
+{
+	for (TActorIterator<AFastRealtimeEndlessTerrain> It(GetWorld()); It; ++It)
+	{
+		It->RestoreUngovernedQuality();
+	}
+	for (TActorIterator<AFastRealtimeMarchingCubePlanet> It(GetWorld()); It; ++It)
+	{
+		It->RestoreUngovernedQuality();
+	}
+}
@@ -6,6 +6,10 @@
 #include "RealtimeMeshActor.h"
 #include "RealtimeMeshSimple.h"
 #include "FastNoiseLayeringFunctions.h"
+#include "FastRealtimeTerrainFlightPath.h"
+#include "FastRealtimeTerrainMemory.h"
+#include "FastRealtimeTerrainMeshOptimizer.h"
+#include "Tasks/Task.h"
 #include "FastRealtimeEndlessTerrain.generated.h"
 
 /**
@@ -51,6 +55,18 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 1, UIMax = 10));
 	uint8 TileGenDepth = 1;
 
+	// Tiles further from the observer than a square this many tiles across are removed as the observer moves, never less than
+	// TileGenDepth. 0 = tiles are kept until the terrain is cleared
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 0, UIMax = 20))
+	uint8 TileEvictionDepth = 0;
+
+	// Number of tiles along each side of a batch region. Tiles within a region are built as their own section groups in one mesh
+	// component shared by the region, rather than each getting a component, cutting component registration, transform & scene
+	// proxy overhead. LODs are picked per batch rather than per tile, & collision is recooked for the whole batch as tiles stream
+	// in & out of it. 0 = every tile gets its own component
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 0, UIMax = 16, ClampMin = 0))
+	int32 TileBatchSize = 0;
+
 	// Number of subdivisions along each side
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 1, UIMax = 100, ClampMin = 1, ClampMax = 100))
 	uint8 TileBuildTimeBudget = 10;
@@ -91,10 +107,83 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain")
 	bool bDoCollision = false;
 
+	// Whether tiles draw their triangles & fetch their verts in an order reordered for the GPU's vertex cache. Every tile at an LOD
+	// shares one grid topology, so the order is worked out once per LOD on a worker task & each tile only pays to copy its streams
+	// into it. Tiles built before their LOD's order is ready keep the plain row order
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain")
+	bool bOptimizeVertexCache = true;
+
 	// Whether or not to log tile generation times
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain")
 	bool bLogTileTimes = false;
 
+	// Whether this terrain's pending tiles are built from the budget the terrain subsystem shares between every terrain actor in the
+	// world, rather than from its own TileBuildTimeBudget. Only has an effect while Terrain.Scheduler.Enable is set
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Scheduling")
+	bool bUseTerrainScheduler = true;
+
+	// Share of the shared budget this terrain gets relative to other terrain actors, before weighting by how far its pending
+	// work is from its observer
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Scheduling", meta = (UIMin = 0.1f, UIMax = 10.0f, ClampMin = 0.01f))
+	float SchedulerPriority = 1.0f;
+
+	// Whether the quality governor can move TileGenDepth & LOD_DistanceScale within the bounds below while Terrain.Governor.Enable
+	// is set. The governor leaves both at their lower quality bounds under sustained load & raises them as frame time allows
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality")
+	bool bAllowQualityGovernor = true;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality", meta = (UIMin = 1, UIMax = 10))
+	uint8 MinGovernedTileGenDepth = 1;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality", meta = (UIMin = 1, UIMax = 10))
+	uint8 MaxGovernedTileGenDepth = 3;
+
+	// Lower distance scales hold finer LODs out to smaller screen sizes, so the minimum is the high quality bound
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality", meta = (UIMin = 0.001f, UIMax = 0.8f, ClampMin = 0.001f, ClampMax = 0.8f))
+	float MinGovernedLODDistanceScale = 0.35f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality", meta = (UIMin = 0.001f, UIMax = 0.8f, ClampMin = 0.001f, ClampMax = 0.8f))
+	float MaxGovernedLODDistanceScale = 0.65f;
+
+	// Whether a single coarse ring mesh is built around the streamed tiles out to FarFieldDepth, so there's a horizon past
+	// TileGenDepth without streaming real tiles out to it. Sampled from the same noise, without smoothing
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|FarField")
+	bool bBuildFarField = false;
+
+	// Number of tiles across the far-field square centered on the observer's tile, always at least one more than TileGenDepth
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|FarField", meta = (UIMin = 1, UIMax = 64))
+	uint8 FarFieldDepth = 15;
+
+	// Number of far-field quads along each side of a tile's footprint
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|FarField", meta = (UIMin = 1, UIMax = 16, ClampMin = 1, ClampMax = 64))
+	int32 FarFieldRes = 2;
+
+	// The far field overlaps the outermost ring of tiles, sunk by this much at the inside of it & by a quarter of it at the
+	// tiles' outer edge, so the tiles always draw over it. Vertex color alpha ramps from 0 to 1 across the overlap, for
+	// materials to dither the far field out with
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|FarField", meta = (UIMin = 0, UIMax = 1000))
+	float FarFieldSinkDepth = 200.0f;
+
+	// Material to use on the far field, null = TerrainMaterial
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|FarField")
+	UMaterialInterface* FarFieldMaterial = nullptr;
+
+	// Memory currently held by the terrain's tiles
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	FTerrainMemoryUsage MemoryUsage;
+
+	// MemoryUsage at its highest since the terrain was last cleared
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	FTerrainMemoryUsage PeakMemoryUsage;
+
+	// Verts generated since the terrain was last cleared, over every LOD
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	int64 TotalVertCount = 0;
+
+	// Noise layer blends evaluated since the terrain was last cleared, including smoothing & normal neighbours
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	int64 TotalNoiseSampleCount = 0;
+
 	// Definitions of noise layers and how they're blended. Blending operations happen linearly through layer entries from index 0 up.
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Noise")
 	TArray<FFN_NoiseLayerType> NoiseLayers;
@@ -119,6 +208,42 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Terrain")
 	void UpdateObserverPosition(FVector ObserverLocation);
 
+	// Logs MemoryUsage & PeakMemoryUsage, & every tile's usage when bDetailed is set
+	void ReportMemoryUsage(FOutputDevice& Ar, bool bDetailed) const;
+
+	// Number of tiles queued by UpdateObserverPosition that haven't been built yet
+	int32 GetPendingTileCount() const { return PendingTerrainTiles.Num(); }
+
+	// Builds pending tiles until BudgetMs has been spent, always building at least one if any are waiting. Called from tick with
+	// TileBuildTimeBudget, or by the terrain subsystem when it's scheduling this terrain. Returns the milliseconds spent
+	float ProcessPendingWork(float BudgetMs);
+
+	// Distance from the last observer location to the nearest pending work, used by the terrain subsystem to favour work
+	// the observer is close to
+	float GetPendingWorkDistance() const;
+
+	// Sets every governed setting between its bounds, 0 = lowest quality, 1 = highest. Streaming radius changes take effect on
+	// the next UpdateObserverPosition & LOD changes on the next tiles built. The first call keeps the settings it replaces
+	void ApplyQualityLevel(float QualityLevel);
+
+	// Puts back the settings ApplyQualityLevel first replaced, once the governor lets go of the actor
+	void RestoreUngovernedQuality();
+
+	// Starts recording observer updates tick by tick, along with the terrain's settings, so the route can be replayed later
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Replay")
+	void StartFlightRecording();
+
+	// Stops recording & writes the flight path to FilePath, returns false if nothing was being recorded or it couldn't be written
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Replay")
+	bool StopFlightRecording(const FString& FilePath);
+
+	// Whether the ground straight below a world space observer location has been built
+	bool IsGroundBuiltUnder(FVector ObserverLocation) const;
+
+	// Launches the tasks working out every LOD's grid draw order if bOptimizeVertexCache is set, & optionally waits for them so
+	// the next tiles built are optimized
+	void PrepareOptimizedGridOrders(bool bWait = false);
+
 	// END PUBLIC FUNCTIONS //
 
 	UPROPERTY()
@@ -129,16 +254,90 @@ private:
 	// Variable to track pending tiles
 	TArray<FVector2D> PendingTerrainTiles;
 
+	// Location passed to the last UpdateObserverPosition call
+	FVector LastObserverLocation = FVector::ZeroVector;
+
 	// Variable to track already built tiles
 	TArray<FVector2D> BuiltTerrainTiles;
 
+	// Memory held by each built tile, indexed the same as BuiltTerrainTiles
+	TArray<FTerrainMemoryUsage> TileMemoryUsage;
+
+	// Component & section groups a built tile's mesh lives in
+	struct FTerrainTileMesh
+	{
+		URealtimeMeshComponent* MeshComp = nullptr;
+
+		// The tile's section group at each of its LODs is keyed by this name
+		FName GroupName;
+
+		int32 LODCount = 0;
+	};
+
+	// Where each built tile's mesh lives, indexed the same as BuiltTerrainTiles
+	TArray<FTerrainTileMesh> TileMeshes;
+
+	// Component shared by every tile built within a batch region, & the LODs it was set up with
+	struct FTerrainTileBatch
+	{
+		URealtimeMeshComponent* MeshComp = nullptr;
+
+		int32 LODCount = 0;
+
+		int32 TileCount = 0;
+	};
+
+	// Batch regions with tiles built in them, keyed by their coord in units of TileBatchSize tiles
+	TMap<FIntPoint, FTerrainTileBatch> TileBatches;
+
+	// Number appended to batched tiles' section group names, so no two tiles in a batch share one
+	int32 NextTileGroupNumber = 0;
+
 	// Section keys
 	TArray<FRealtimeMeshSectionKey> SectionKeys;
 
-	// Array of mesh comps
+	// Designer set values of the governed settings, kept while the quality governor is overriding them
+	bool bQualityGoverned = false;
+	uint8 UngovernedTileGenDepth = 0;
+	float UngovernedLODDistanceScale = 0.0f;
+
+	// Flight path being recorded, if any, & the frame that'll be added to it on the next tick
+	TOptional<FTerrainFlightPath> FlightRecording;
+	FTerrainFlightPathFrame RecordingFrame;
+
+	// Array of mesh comps, every tile's or batch's
 	UPROPERTY()
 	TArray<URealtimeMeshComponent*> GeneratedMeshComps;
 
+	// Far-field ring mesh, null until it's first built
+	UPROPERTY()
+	URealtimeMeshComponent* FarFieldMeshComp = nullptr;
+
+	// Far-field heights keyed by world sample coord, kept between updates so only samples new to the ring are sampled
+	TMap<FIntPoint, float> FarFieldHeights;
+
+	// Sample coord the far field was last built around
+	TOptional<FIntPoint> FarFieldCenterSample;
+
+	// Memory held by the far-field mesh, included in MemoryUsage
+	FTerrainMemoryUsage FarFieldMemoryUsage;
+
+	// Rebuilds the far field around the observer's snapped tile if it's moved since the last build
+	void UpdateFarField(const FVector2D& SnappedObserverLocation);
+
+	// Creates & registers a mesh component set up for tiles with LODCount LODs
+	URealtimeMeshComponent* CreateTileMeshComp(int32 LODCount);
+
+	// Removes a built tile's mesh, destroying its component once nothing else is built in it
+	void RemoveTerrainTile(int32 TileIndex);
+
+	// Vertex cache friendly draw orders for tile grids, keyed by the number of quads along each side
+	TMap<int32, UE::Tasks::TTask<FTerrainMeshOptimizedOrder>> OptimizedGridOrders;
+
+	// Draw order for a grid with QuadRes quads along each side, launching the task that works it out if there isn't one yet.
+	// Null until that task has finished
+	const FTerrainMeshOptimizedOrder* GetOptimizedGridOrder(int32 QuadRes);
+
 	// Function to snap observer position to grid
 	FVector2D SnapPositionToGrid(FVector DiscreetPosition) const;
 };
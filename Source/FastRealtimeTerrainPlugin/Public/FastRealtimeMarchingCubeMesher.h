@@ -0,0 +1,203 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RealtimeMeshSimple.h"
+#include "RealtimeMeshComponent.h"
+#include "FastRealtimePlanetEditOps.h"
+#include "FastRealtimeMarchingCubeMesher.generated.h"
+
+struct FTriangulationData;
+
+UENUM(BlueprintType)
+enum class EPlanetMesherType : uint8
+{
+	// Triangulation table lookup per cube
+	MarchingCubes,
+
+	// One vertex per surface cell placed from its edge crossings, with a quad across every edge the surface crosses
+	SurfaceNets
+};
+
+// Immutable triangulation table shared between the planet actor & any in-flight chunk builds
+typedef TSharedPtr<const TArray<FTriangulationData>, ESPMode::ThreadSafe> FPlanetTriangulationTablePtr;
+
+/**
+ * Integer key for a planet chunk. Base chunks are LOD 0, an octree node at LOD N covers 2^N base chunks along each
+ * side & its Coord is in units of its own size.
+ */
+struct FPlanetChunkKey
+{
+	FIntVector Coord = FIntVector::ZeroValue;
+	int32 LOD = 0;
+
+	FPlanetChunkKey() = default;
+	FPlanetChunkKey(const FIntVector& InCoord, int32 InLOD) : Coord(InCoord), LOD(InLOD) {}
+
+	bool operator==(const FPlanetChunkKey& Other) const { return Coord == Other.Coord && LOD == Other.LOD; }
+	bool operator!=(const FPlanetChunkKey& Other) const { return !(*this == Other); }
+
+	// Whether one of the two keys covers the other, or they're the same key
+	bool Overlaps(const FPlanetChunkKey& Other) const
+	{
+		const FPlanetChunkKey& Coarse = LOD >= Other.LOD ? *this : Other;
+		const FPlanetChunkKey& Fine = LOD >= Other.LOD ? Other : *this;
+		const int32 Shift = Coarse.LOD - Fine.LOD;
+		return FIntVector(Fine.Coord.X >> Shift, Fine.Coord.Y >> Shift, Fine.Coord.Z >> Shift) == Coarse.Coord;
+	}
+
+	friend uint32 GetTypeHash(const FPlanetChunkKey& Key) { return HashCombine(GetTypeHash(Key.Coord), ::GetTypeHash(Key.LOD)); }
+};
+
+/**
+ * Snapshot of everything a worker task needs to mesh a single planet chunk. Gathered on the game thread so the
+ * worker never touches the actor or its scalar field.
+ */
+struct FPlanetChunkBuildInput
+{
+	// Component the result should be applied to, only dereferenced back on the game thread
+	TWeakObjectPtr<URealtimeMeshComponent> MeshComp;
+
+	// Chunk or octree node being built
+	FPlanetChunkKey ChunkKey;
+
+	// Serial of this build, used to drop results that were superseded by a newer build of the same chunk
+	uint32 BuildSerial = 0;
+
+	// Whether this build replaces existing geometry on MeshComp
+	bool bUpdate = false;
+
+	// Actor space position of the chunk's min corner
+	FVector3f InitialOffsetPosition = FVector3f::ZeroVector;
+
+	// Algorithm used to turn the snapshot into triangles
+	EPlanetMesherType MesherType = EPlanetMesherType::MarchingCubes;
+
+	// Number of cubes along each side of the chunk
+	int32 CubeCount = 0;
+
+	// Size of a single cube
+	float StepSize = 0.0f;
+
+	// Cubes whose centers are further than this from the planet center (+ one step) are skipped
+	float SkipRadius = 0.0f;
+
+	// Depth of the skirts hung from the chunk's boundary edges to hide cracks against neighbours at other LODs, 0 = no skirts
+	float SkirtDepth = 0.0f;
+
+	// Number of cubes along each side of a section brick, each section brick is built into its own stream set
+	int32 SectionSize = 0;
+
+	// Whether each section's streams are reordered for the vertex cache once they're built
+	bool bOptimizeVertexCache = false;
+
+	// Section bricks to build, empty = every section brick in the chunk
+	TArray<FIntVector> SectionBricks;
+
+	// First chunk-local sample covered by Samples, & the number of samples it covers along each axis. Snapshots reach
+	// GetSnapshotApron samples past either side of the cubes being built
+	FIntVector SnapshotOrigin = FIntVector::ZeroValue;
+	FIntVector SnapshotRes = FIntVector::ZeroValue;
+
+	// Scalar field samples covering the section bricks being built, X fastest
+	TArray<float> Samples;
+
+	// Edits to layer over Samples before meshing, in the order they were made
+	TArray<FPlanetEditOp> EditOps;
+
+	// Where the snapshot sits in the scalar field, for placing its samples in actor space when applying EditOps: the field sample
+	// at the chunk's min corner, field samples per snapshot sample, the distance between field samples & field sample 0's position
+	FIntVector FieldSampleOrigin = FIntVector::ZeroValue;
+	int32 FieldSampleStride = 1;
+	float FieldSampleStep = 0.0f;
+	FVector3f FieldOrigin = FVector3f::ZeroVector;
+
+	// Triangulation table to look case data up from
+	FPlanetTriangulationTablePtr TriangulationTable;
+};
+
+/**
+ * Mesh for a single section brick of a chunk.
+ */
+struct FPlanetChunkSectionResult
+{
+	// Linear index of the section brick within its chunk, X fastest
+	int32 SectionIndex = 0;
+
+	// Highest triangle index offset written, 0 if the section produced no geometry
+	int32 MaxTri = 0;
+
+	// Number of verts & triangles written to StreamSet
+	int32 VertexCount = 0;
+	int32 TriangleCount = 0;
+
+	FRealtimeMeshStreamSet StreamSet;
+};
+
+/**
+ * Finished chunk mesh handed back from a worker task, ready to be applied to its component on the game thread.
+ */
+struct FPlanetChunkBuildResult
+{
+	TWeakObjectPtr<URealtimeMeshComponent> MeshComp;
+
+	FPlanetChunkKey ChunkKey;
+
+	uint32 BuildSerial = 0;
+
+	bool bUpdate = false;
+
+	// Whether every section brick of the chunk was built, rather than only the ones touched by an edit
+	bool bAllSections = true;
+
+	// Sum of the section MaxTri values, 0 if the chunk produced no geometry
+	int32 MaxTri = 0;
+
+	TArray<FPlanetChunkSectionResult> Sections;
+};
+
+/**
+ * Stateless marching cubes & surface nets mesher for planet chunks, safe to run from any thread.
+ */
+class FASTREALTIMETERRAINPLUGIN_API FFastRealtimeMarchingCubeMesher
+{
+public:
+
+	// Layers the input's edits over its snapshot, each only over the samples its bounds reach. Run before BuildChunk
+	static void ApplyEditOps(FPlanetChunkBuildInput& Input);
+
+	// Builds a stream set per section brick of a single chunk from its scalar snapshot
+	static void BuildChunk(const FPlanetChunkBuildInput& Input, FPlanetChunkBuildResult& Result);
+
+	// Samples needed either side of the cubes a section builds, for central difference normals at its corners. Surface nets also
+	// places verts in the cells just before its first cube, so needs one more
+	static int32 GetSnapshotApron(EPlanetMesherType MesherType) { return MesherType == EPlanetMesherType::SurfaceNets ? 2 : 1; }
+
+	// Largest section brick size whose worst case vertex count still fits 16 bit indices, larger sections are split down to it
+	static int32 GetMaxSectionSize(EPlanetMesherType MesherType, const FPlanetTriangulationTablePtr& TriangulationTable, bool bSkirts);
+
+	// Whether a section with this many verts can pack its triangles as 16 bit indices
+	static bool Uses16BitIndices(int32 VertexCount) { return VertexCount <= MAX_uint16; }
+
+	// Number of section bricks along each side of a chunk
+	static int32 GetSectionRes(int32 CubeCount, int32 SectionSize) { return FMath::DivideAndRoundUp(CubeCount, FMath::Max(SectionSize > 0 ? SectionSize : CubeCount, 1)); }
+
+	// Scalar value separating solid (below) from empty space (at or above)
+	static constexpr float IsoLevel = 0.5f;
+
+	// IsoLevel as stored in the quantized scalar field
+	static constexpr uint8 QuantizedIsoLevel = 128;
+
+	// Builds the case index for a cube from its 8 vertex values
+	static int32 BinaryFromVertices(const TArray<float>& Vertices);
+
+private:
+
+	struct FSectionBuilders;
+
+	// Mesh a section brick's cube range (max exclusive) into the section's stream set, returning its MaxTri. Density is the
+	// snapshot quantized to 8 bits
+	static int32 BuildMarchingCubesSection(const FPlanetChunkBuildInput& Input, const TArray<uint8>& Density, const FIntVector& CubeMin, const FIntVector& CubeMax, FPlanetChunkSectionResult& Section);
+	static int32 BuildSurfaceNetsSection(const FPlanetChunkBuildInput& Input, const FIntVector& CubeMin, const FIntVector& CubeMax, FPlanetChunkSectionResult& Section);
+};
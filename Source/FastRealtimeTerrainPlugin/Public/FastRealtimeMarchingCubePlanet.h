@@ -8,6 +8,13 @@
 #include "RealtimeMeshComponent.h"
 #include "FastNoiseLayeringFunctions.h"
 #include "Components/BoxComponent.h"
+#include "Tasks/Task.h"
+#include "FastRealtimeMarchingCubeMesher.h"
+#include "FastRealtimePlanetScalarField.h"
+#include "FastRealtimePlanetEditOps.h"
+#include "FastRealtimePlanetEditJournal.h"
+#include "FastRealtimeTerrainFlightPath.h"
+#include "FastRealtimeTerrainMemory.h"
 #include "FastRealtimeMarchingCubePlanet.generated.h"
 
 /**
@@ -64,6 +71,66 @@ USTRUCT(BlueprintType) struct FTriangulationData : public FTableRowBase
 	
 };
 
+// Min & max quantized scalar value over a chunk's samples, a chunk can only contain surface if they straddle the iso level
+struct FPlanetChunkDensityRange
+{
+	uint8 Min = 255;
+	uint8 Max = 0;
+};
+
+// A section group created on a chunk comp's realtime mesh
+struct FPlanetBuiltSection
+{
+	FTerrainMemoryUsage MemoryUsage;
+
+	int32 TriangleCount = 0;
+};
+
+// Build bookkeeping for a single chunk comp
+struct FPlanetChunkBuildState
+{
+	// Latest build serial issued, older results are dropped when they complete
+	uint32 LatestSerial = 0;
+
+	// Whether the latest build has yet to be applied
+	bool bInFlight = false;
+
+	// Chunk or octree node the comp was last built for
+	FPlanetChunkKey ChunkKey;
+
+	// Section bricks the latest build covers, empty = every section brick
+	TArray<FIntVector> SectionBricks;
+
+	// Section groups currently created on the comp's realtime mesh, by section index
+	TMap<int32, FPlanetBuiltSection> BuiltSections;
+
+	FTerrainMemoryUsage GetMemoryUsage() const
+	{
+		FTerrainMemoryUsage Usage;
+		for (const TPair<int32, FPlanetBuiltSection>& Section : BuiltSections)
+		{
+			Usage += Section.Value.MemoryUsage;
+		}
+		return Usage;
+	}
+
+	int64 GetTriangleCount() const
+	{
+		int64 TriangleCount = 0;
+		for (const TPair<int32, FPlanetBuiltSection>& Section : BuiltSections)
+		{
+			TriangleCount += Section.Value.TriangleCount;
+		}
+		return TriangleCount;
+	}
+};
+
+// Octree chunk comp that's been replaced by a split or merge, kept visible until the leaves replacing it have been built
+struct FPlanetRetiringChunk
+{
+	TWeakObjectPtr<URealtimeMeshComponent> MeshComp;
+	TArray<FPlanetChunkKey> Replacements;
+};
 
 UCLASS()
 class FASTREALTIMETERRAINPLUGIN_API AFastRealtimeMarchingCubePlanet : public ARealtimeMeshActor
@@ -101,9 +168,32 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 3, UIMax = 100))
 	int32 CubeRes = 5;
 
+	// Number of cubes along each side of a chunk section, each section is its own section group so edits only remesh & re-upload
+	// the sections they touch. 0 = one section per chunk. Clamped to the largest size guaranteed to fit 16 bit indices
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 0, UIMax = 32, ClampMin = 0))
+	int32 SectionBrickSize = 8;
+
+	// Algorithm chunks are meshed with. Surface nets shares one vertex per cell between its faces, giving fewer verts & smoother
+	// shading, but ignores LOD seam skirts
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain")
+	EPlanetMesherType MesherType = EPlanetMesherType::MarchingCubes;
+
+	// Whether each chunk section's triangles & verts are reordered for the GPU's vertex cache & fetch once they're meshed. Runs
+	// alongside meshing on the chunk's build task, so costs build time off the game thread for faster draws for the chunk's lifetime
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain")
+	bool bOptimizeVertexCache = true;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 0, UIMax = 100))
 	int32 BuildChunkTimeBudget = 2;
 
+	// Whether chunks are meshed on worker tasks, with the game thread only applying finished results
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain")
+	bool bAsyncChunkBuilds = true;
+
+	// Max number of chunk builds in flight at once, 0 = one per task graph worker thread
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 0, UIMax = 64, ClampMin = 0))
+	int32 MaxConcurrentChunkBuilds = 0;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 0.0f, UIMax = 1.0f))
 	float SurfaceHeight = 0.5f;
 
@@ -140,28 +230,165 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 1, UIMax = 100))
 	float NoiseDisplacementStrength = 0.0f;
 
+	// Largest absolute value the blended noise layers can return. Samples further than this * NoiseDisplacementStrength from the surface
+	// are classified from their radius alone without evaluating noise, so raise it if noise layers can exceed +-1
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain", meta = (UIMin = 0.0f, UIMax = 10.0f, ClampMin = 0.0f))
+	float NoiseAmplitudeBound = 1.0f;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain")
 	TArray<FFN_NoiseLayerType> NoiseLayers;
 
+	// Whether the generated scalar field is saved to disk & memory mapped back in by later generations with the same seed &
+	// settings, rather than being regenerated. Ignored with bRandomSeed
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Cache")
+	bool bCacheScalarField = false;
+
+	// Directory scalar field snapshots are kept in, defaults to Saved/PlanetFieldCache when empty
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Cache")
+	FString ScalarFieldCacheDirectory;
+
+	// Whether chunks are organised into an octree of LODs around the observer, rather than all being meshed at full resolution
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|LOD")
+	bool bUseOctreeLOD = false;
+
+	// Number of octree levels above the base chunks, each level doubles the size a single chunk covers at the same PerCompRes
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|LOD", meta = (UIMin = 0, UIMax = 8, ClampMin = 0, ClampMax = 8))
+	int32 OctreeMaxLOD = 3;
+
+	// Octree nodes closer to the observer than their size * this are split into their 8 children
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|LOD", meta = (UIMin = 0.5f, UIMax = 8.0f, ClampMin = 0.0f))
+	float LODSplitDistanceScale = 1.5f;
+
+	// Split nodes only merge back once the observer is further than their split distance * this, so LODs don't flicker on the boundary
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|LOD", meta = (UIMin = 1.0f, UIMax = 2.0f, ClampMin = 1.0f))
+	float LODMergeHysteresis = 1.25f;
+
+	// Whether to hang skirts off octree chunk boundaries to hide cracks between neighbouring LODs
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|LOD")
+	bool bStitchLODSeams = true;
+
+	// Triangles in every chunk's built sections, recounted along with MemoryUsage
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Stats")
 	int64 TotalTriCount;
 
+	// Verts meshed into chunks since the planet was last cleared
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	int64 TotalVertCount = 0;
+
+	// Whether this planet's pending chunks are built from the budget the terrain subsystem shares between every terrain actor in the
+	// world, rather than from its own BuildChunkTimeBudget. Only has an effect while Terrain.Scheduler.Enable is set
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Scheduling")
+	bool bUseTerrainScheduler = true;
+
+	// Share of the shared budget this planet gets relative to other terrain actors, before weighting by how far its pending
+	// work is from its observer
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Scheduling", meta = (UIMin = 0.1f, UIMax = 10.0f, ClampMin = 0.01f))
+	float SchedulerPriority = 1.0f;
+
+	// Whether the quality governor can move LODSplitDistanceScale within the bounds below while Terrain.Governor.Enable is set.
+	// The governor leaves it at the lower bound under sustained load & raises it as frame time allows
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality")
+	bool bAllowQualityGovernor = true;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality", meta = (UIMin = 0.5f, UIMax = 8.0f, ClampMin = 0.0f))
+	float MinGovernedLODSplitDistanceScale = 1.0f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Terrain|Quality", meta = (UIMin = 0.5f, UIMax = 8.0f, ClampMin = 0.0f))
+	float MaxGovernedLODSplitDistanceScale = 2.0f;
+
+	// Memory currently held by the planet's chunks, scalar field & edits
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	FTerrainMemoryUsage MemoryUsage;
+
+	// MemoryUsage at its highest since the planet was last cleared
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	FTerrainMemoryUsage PeakMemoryUsage;
+
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Terrain")
 	void GenerateMesh();
 
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Terrain")
 	void GenerateMeshDeferred();
 
-	// Calls function to build single terrain chunk
+	// Calls function to build single terrain chunk. When bAsyncChunkBuilds is set the chunk is meshed on a worker task & applied on a later tick
 	UFUNCTION(BlueprintCallable, Category = "Terrain")
 	void GenerateTerrainChunk(const FVector TileCenter = FVector(0.0f), bool Update = false);
 
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Terrain")
 	void ClearGeneratedMesh();
 
+	// Writes every edit made to the planet to a compact binary journal file
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Edits")
+	bool SaveEditJournal(const FString& FilePath) const;
+
+	// Replays a journal file written by SaveEditJournal, skipping any edits the planet already has
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Edits")
+	bool LoadEditJournal(const FString& FilePath);
+
+	// Number of edits made to the planet so far, including ones still waiting to be applied
+	UFUNCTION(BlueprintPure, Category = "Terrain|Edits")
+	int32 GetEditOpCount() const { return EditOps.Num() + PendingEditOps.Num(); }
+
+	// Encodes up to MaxOps edits starting from FirstOp, for streaming edits to clients a range at a time
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Edits")
+	void GetEditJournalRange(int32 FirstOp, int32 MaxOps, TArray<uint8>& OutJournal) const;
+
+	// Queues the edits from a journal range, skipping any the planet already has. Returns false if the journal is malformed or
+	// starts past the planet's last edit
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Edits")
+	bool ApplyEditJournal(const TArray<uint8>& Journal);
+
+	// Splits & merges octree chunks around a world space observer location, only does anything when bUseOctreeLOD is set
+	UFUNCTION(BlueprintCallable, Category = "Terrain")
+	void UpdateObserverPosition(FVector ObserverLocation);
+
+	// Queues a sphere edit of the planet, edits are applied together on the next tick so every affected chunk only remeshes once
 	UFUNCTION(BlueprintCallable, Category = "Terrain")
 	static void AffectPlanetGeo(AFastRealtimeMarchingCubePlanet* PlanetRef, FVector EffectLocation, float EffectRadius, bool AddTo);
 
+	// Queues a capsule edit between two world space points, Smoothness blends the edit into the existing surface
+	UFUNCTION(BlueprintCallable, Category = "Terrain")
+	static void AffectPlanetGeoCapsule(AFastRealtimeMarchingCubePlanet* PlanetRef, FVector Start, FVector End, float Radius, bool AddTo, float Smoothness = 0.0f);
+
+	// Queues a box edit, Extent is the box's half size & Smoothness blends the edit into the existing surface
+	UFUNCTION(BlueprintCallable, Category = "Terrain")
+	static void AffectPlanetGeoBox(AFastRealtimeMarchingCubePlanet* PlanetRef, FVector Center, FRotator Rotation, FVector Extent, bool AddTo, float Smoothness = 0.0f);
+
+	// Logs MemoryUsage & PeakMemoryUsage, & every chunk's usage when bDetailed is set
+	void ReportMemoryUsage(FOutputDevice& Ar, bool bDetailed) const;
+
+	// Number of chunks still queued or being meshed on worker tasks
+	int32 GetPendingChunkCount() const { return PendingTerrainChunks.Num() + PendingOctreeChunks.Num() + InFlightChunkBuilds.Num(); }
+
+	// Applies finished chunk builds & launches pending ones until BudgetMs has been spent, always launching at least one if any
+	// are waiting. Called from tick with BuildChunkTimeBudget, or by the terrain subsystem when it's scheduling this planet.
+	// Returns the milliseconds spent
+	float ProcessPendingWork(float BudgetMs);
+
+	// Distance from the last observer location to the planet's surface, used by the terrain subsystem to favour planets the
+	// observer is close to
+	float GetPendingWorkDistance() const;
+
+	// Sets every governed setting between its bounds, 0 = lowest quality, 1 = highest. Octree LODs are resplit straight away.
+	// The first call keeps the settings it replaces
+	void ApplyQualityLevel(float QualityLevel);
+
+	// Puts back the settings ApplyQualityLevel first replaced, once the governor lets go of the actor
+	void RestoreUngovernedQuality();
+
+	// Starts recording observer updates & edits tick by tick, along with the planet's settings, so the route can be replayed later.
+	// Edits made before recording started go in the first frame
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Replay")
+	void StartFlightRecording();
+
+	// Stops recording & writes the flight path to FilePath, returns false if nothing was being recorded or it couldn't be written
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Replay")
+	bool StopFlightRecording(const FString& FilePath);
+
+	// Whether the chunk straight below a world space observer location has been built & has no rebuild pending, taking the
+	// ground as the undisplaced surface on the line from the observer to the planet's center
+	bool IsGroundBuiltUnder(FVector ObserverLocation) const;
+
 private:
 
 	UPROPERTY()
@@ -173,27 +400,149 @@ private:
 	UPROPERTY()
 	TArray<FVector> PendingTerrainChunks;
 
-	UPROPERTY()
-	TArray<float> ScalarField;
+	// Sparse brick storage for the planet's (ComponentBreakupScale * PerCompRes + 1)^3 scalar samples
+	FPlanetScalarField ScalarField;
 
 	UPROPERTY()
 	TMap<URealtimeMeshComponent*, FVector> GeneratedMeshComps;
-	
-	TStaticArray<FTriangulationData, 254> TriangulationTableData;
+
+	// Base chunk comps by chunk coordinate
+	TMap<FIntVector, URealtimeMeshComponent*> ChunkMeshComps;
+
+	// Every edit made to the planet so far, in order. Edits are never written into ScalarField, they're applied on top of it
+	// whenever a chunk is snapshotted
+	TArray<FPlanetEditOp> EditOps;
+
+	// Indices into EditOps of the edits overlapping each base chunk, in order
+	TMap<FIntVector, TArray<int32>> ChunkEditOps;
+
+	// Edits made since the last tick
+	TArray<FPlanetEditOp> PendingEditOps;
+
+	// Per-chunk density summaries, indexed by chunk coordinate & kept up to date as the field is built & edited
+	TArray<FPlanetChunkDensityRange> ChunkDensityRanges;
+
+	// Chunk builds running on worker tasks, drained on tick
+	TArray<UE::Tasks::TTask<TSharedPtr<FPlanetChunkBuildResult, ESPMode::ThreadSafe>>> InFlightChunkBuilds;
+
+	// Build serials & built sections per chunk component
+	TMap<TWeakObjectPtr<URealtimeMeshComponent>, FPlanetChunkBuildState> ChunkBuildStates;
+
+	uint32 NextChunkBuildSerial = 0;
+
+	// Observer location in actor space, as of the last UpdateObserverPosition call
+	FVector ObserverLocalPosition = FVector::ZeroVector;
+
+	// Current octree leaves, & the comps of those that have been built. Comps are also tracked in GeneratedMeshComps
+	TSet<FPlanetChunkKey> OctreeLeaves;
+	TMap<FPlanetChunkKey, URealtimeMeshComponent*> OctreeMeshComps;
+
+	// Octree leaves waiting to be built, closest to the observer first
+	TArray<FPlanetChunkKey> PendingOctreeChunks;
+
+	// Octree leaves that are queued or in flight & haven't had a result applied yet
+	TSet<FPlanetChunkKey> UnsettledOctreeChunks;
+
+	TArray<FPlanetRetiringChunk> RetiringOctreeChunks;
+
+	// Shared so in-flight chunk builds keep reading a consistent table even if it's reinitialized
+	FPlanetTriangulationTablePtr TriangulationTableData;
 	
 	TStaticArray<FVector3f, 8> VertexDirections;
 
 	// Section keys
 	TArray<FRealtimeMeshSectionKey> SectionKeys;
-	
-	static int32 BinaryFromVertices(TArray<float>& Vertices);
 
-	int32 ScalarIndexLookupFromLocalLocation(FVector LocalLocation) const;
+	// Memory held by the mesh GenerateMesh builds on the actor's own comp
+	FTerrainMemoryUsage RootMeshMemoryUsage;
+
+	// Whether MemoryUsage needs recounting, it's recounted at most once a tick
+	bool bMemoryUsageDirty = false;
+
+	// Designer set value of the governed setting, kept while the quality governor is overriding it
+	bool bQualityGoverned = false;
+	float UngovernedLODSplitDistanceScale = 0.0f;
+
+	// Resplits the octree if the split distance scale has changed
+	void SetLODSplitDistanceScale(float NewSplitDistanceScale);
+
+	// Flight path being recorded, if any, the frame that'll be added to it on the next tick & how many edits it already holds
+	TOptional<FTerrainFlightPath> FlightRecording;
+	FTerrainFlightPathFrame RecordingFrame;
+	int32 RecordedEditOpCount = 0;
+
+	// Recounts MemoryUsage from every chunk & the field, raising PeakMemoryUsage if it's grown past it, & TotalTriCount from every chunk
+	void UpdateMemoryUsage();
+
+	// Conversions between a chunk's integer coordinate & its actor space center
+	FIntVector ChunkCoordFromCenter(const FVector& ChunkCenter) const;
+	FVector ChunkCenterFromCoord(const FIntVector& ChunkCoord) const;
+
+	// Recomputes density summaries for every chunk in the coordinate range (inclusive)
+	void UpdateChunkDensityRanges(const FIntVector& MinChunk, const FIntVector& MaxChunk);
+
+	// Whether a chunk's density summary straddles the iso level, chunks that don't are never meshed
+	bool ChunkCanContainSurface(const FIntVector& ChunkCoord) const;
+
+	// Queues an actor space edit to be applied on the next tick
+	void QueueEditOp(FPlanetEditOp Op);
+
+	// Step edit journal positions & sizes are quantized to, edits are quantized as they're queued so replays match exactly
+	float GetEditJournalQuantum() const { return PlanetSize / (ComponentBreakupScale * PerCompRes) / 64.0f; }
+
+	// Cubes along each side of a section brick, SectionBrickSize clamped so no section can outgrow 16 bit indices
+	int32 GetSectionSize() const;
+
+	// Indexes every queued edit by the chunks it overlaps, then remeshes each chunk they dirtied once
+	void ApplyPendingGeoEdits();
+
+	// Sorted indices of the edits overlapping any base chunk a chunk or octree node covers
+	void GatherChunkEditOps(const FPlanetChunkKey& ChunkKey, TArray<int32>& OutEditOps) const;
+
+	// Actor space bounds of a base chunk or octree node
+	FBox GetChunkBounds(const FPlanetChunkKey& ChunkKey) const;
+
+	// Whether any base chunk an octree node covers can contain surface
+	bool NodeCanContainSurface(const FPlanetChunkKey& ChunkKey) const;
+
+	// Rebuilds the set of octree leaves around the observer, queueing new leaves & retiring the ones they replace
+	void UpdateOctree();
+
+	// Walks down from an octree node, splitting nodes close to the observer & adding the rest to OutLeaves
+	void CollectOctreeLeaves(const FPlanetChunkKey& ChunkKey, bool bInsideOldLeaf, TSet<FPlanetChunkKey>& OutLeaves) const;
+
+	// Destroys retiring octree comps once every leaf replacing them has been built
+	void RetireSettledOctreeChunks();
+
+	// Builds a single octree leaf, creating its comp if it doesn't have one yet
+	void GenerateOctreeChunk(const FPlanetChunkKey& ChunkKey, bool Update);
+
+	// Sets up a new, empty chunk component
+	URealtimeMeshComponent* CreateChunkMeshComp(const FVector& ChunkCenter);
+
+	// Snapshots a base chunk or octree node's samples at its LOD stride & meshes them, on a worker task if bAsyncChunkBuilds is set.
+	// Only the given section bricks are rebuilt when there are any
+	void LaunchChunkBuild(const FPlanetChunkKey& ChunkKey, URealtimeMeshComponent* MeshComp, bool Update, TArray<FIntVector> SectionBricks = TArray<FIntVector>());
+
+	// Creates the realtime mesh on a chunk component & sets up its collision
+	URealtimeMeshSimple* InitializeChunkRealtimeMesh(URealtimeMeshComponent* MeshComp) const;
+
+	// Applies a finished chunk build to its component, game thread only
+	void ApplyChunkBuildResult(FPlanetChunkBuildResult& Result);
 	
 	void GetTriangulationData(FTriangulationData& TriangulationData, const int32 Key);
 
 	void InitializeTriangulationTableData();
 
+	// Generates or maps in the scalar field, along with the density range of every chunk
 	void InitializeScalarField();
+
+	// Hash of everything the scalar field is generated from, snapshots are only reused when it matches
+	uint64 GetScalarFieldCacheKey() const;
+
+	FString GetScalarFieldCachePath(uint64 CacheKey) const;
+
+	// Bump whenever InitializeScalarField changes what it generates, so older snapshots are ignored
+	static constexpr uint32 ScalarFieldGeneratorVersion = 2;
 	
 };
@@ -0,0 +1,30 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FastRealtimePlanetEditOps.h"
+
+/**
+ * Compact binary encoding of a run of planet edit ops, for saving edits to disk & streaming them to clients. Positions are
+ * quantized to a fixed step & delta encoded against the previous op as variable length integers, so runs of nearby edits
+ * from digging tools cost a handful of bytes each.
+ */
+class FASTREALTIMETERRAINPLUGIN_API FPlanetEditJournal
+{
+public:
+
+	// Rounds an op's values to what it'll decode to, so the planet applying it matches anyone replaying its journal
+	static void QuantizeOp(FPlanetEditOp& Op, float Quantum);
+
+	// Encodes Ops, which start at index FirstOp in the planet's edit list, appending them to OutBytes
+	static void Encode(TConstArrayView<FPlanetEditOp> Ops, int32 FirstOp, float Quantum, TArray<uint8>& OutBytes);
+
+	// Decodes a journal written by Encode, returns false if it's malformed
+	static bool Decode(TConstArrayView<uint8> Bytes, int32& OutFirstOp, TArray<FPlanetEditOp>& OutOps);
+
+private:
+
+	static constexpr uint32 Magic = 0x4A455046; // 'FPEJ'
+	static constexpr uint8 Version = 1;
+};
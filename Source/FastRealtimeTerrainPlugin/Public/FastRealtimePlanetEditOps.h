@@ -0,0 +1,54 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FastRealtimePlanetEditOps.generated.h"
+
+UENUM(BlueprintType)
+enum class EPlanetEditShape : uint8
+{
+	Sphere,
+	Capsule,
+	Box
+};
+
+/**
+ * Single SDF edit of the marching cube planet, evaluated against the base scalar field whenever a chunk is snapshotted
+ * rather than being written into it. All positions are in actor space.
+ */
+struct FASTREALTIMETERRAINPLUGIN_API FPlanetEditOp
+{
+	EPlanetEditShape Shape = EPlanetEditShape::Sphere;
+
+	// Whether the shape adds solid ground, or carves it away
+	bool bAddTo = false;
+
+	// Sphere & box center, capsule start
+	FVector3f A = FVector3f::ZeroVector;
+
+	// Capsule end
+	FVector3f B = FVector3f::ZeroVector;
+
+	// Box half extents
+	FVector3f Extent = FVector3f::ZeroVector;
+
+	// Box rotation
+	FQuat4f Rotation = FQuat4f::Identity;
+
+	// Sphere & capsule radius
+	float Radius = 0.0f;
+
+	// Width of the smooth blend between the shape & the existing surface, 0 = hard edged
+	float Smoothness = 0.0f;
+
+	// Signed distance from P to the shape's surface, negative inside
+	float SignedDistance(const FVector3f& P) const;
+
+	// Region the op can affect, including its smooth blend
+	FBox3f GetBounds() const;
+
+	// Combines the op with a scalar field value at P. DensityScale is the distance over which the field goes from the iso
+	// level to fully solid or empty
+	float Apply(float Value, const FVector3f& P, float DensityScale) const;
+};
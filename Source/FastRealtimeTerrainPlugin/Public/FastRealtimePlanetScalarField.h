@@ -0,0 +1,134 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Sparse scalar field for the marching cube planet. Samples are grouped into fixed size bricks; bricks where every
+ * sample holds the same value collapse down to that single value, the rest store their samples quantized to 8 bits
+ * in a shared payload pool. Bricks are written once while the field is generated & only read after that, edits are
+ * layered on top by the chunk builds. A field can also be saved to disk & memory mapped back in, in which case its
+ * payloads are paged in by the OS as they're read.
+ */
+class FASTREALTIMETERRAINPLUGIN_API FPlanetScalarField
+{
+public:
+
+	FPlanetScalarField();
+	~FPlanetScalarField();
+
+	FPlanetScalarField(const FPlanetScalarField&) = delete;
+	FPlanetScalarField& operator=(const FPlanetScalarField&) = delete;
+
+	// Number of samples along each side of a brick, must be a power of 2
+	static constexpr int32 BrickSizeLog2 = 3;
+	static constexpr int32 BrickSize = 1 << BrickSizeLog2;
+	static constexpr int32 BrickSampleCount = BrickSize * BrickSize * BrickSize;
+
+	// Sets up an (InSampleRes)^3 field with every brick collapsed to FillValue
+	void Init(int32 InSampleRes, float FillValue);
+
+	void Empty();
+
+	bool IsEmpty() const { return SampleRes == 0; }
+
+	// Number of samples along each side of the field
+	int32 GetSampleRes() const { return SampleRes; }
+
+	// Number of bricks along each side of the field
+	int32 GetBrickRes() const { return BrickRes; }
+
+	bool IsValidSample(const FIntVector& Sample) const
+	{
+		return Sample.X >= 0 && Sample.Y >= 0 && Sample.Z >= 0 && Sample.X < SampleRes && Sample.Y < SampleRes && Sample.Z < SampleRes;
+	}
+
+	// Sample lookups, the sample must be valid
+	uint8 GetQuantizedSample(const FIntVector& Sample) const;
+	float GetSample(const FIntVector& Sample) const { return DequantizeValue(GetQuantizedSample(Sample)); }
+
+	// Writes a whole brick of BrickSampleCount quantized samples (X fastest), collapsing it if they're all the same. Each
+	// brick is only meant to be written once after Init, while the field is generated
+	void SetBrick(const FIntVector& Brick, const uint8* Samples);
+
+	// Finds the min & max quantized value over the sample range (inclusive), uniform bricks are read without touching samples
+	void GetRangeMinMax(const FIntVector& MinSample, const FIntVector& MaxSample, uint8& OutMin, uint8& OutMax) const;
+
+	// Bytes currently held by the brick map & sample payloads, not counting mapped payloads
+	SIZE_T GetAllocatedSize() const;
+
+	// Writes the field to a snapshot file tagged with Key, which should identify everything the field was generated from.
+	// Summary is stored alongside the brick map for the caller to keep anything it derives from the field, so it can be
+	// loaded back without reading every payload
+	bool SaveToFile(const FString& FilePath, uint64 Key, TConstArrayView<uint8> Summary = TConstArrayView<uint8>()) const;
+
+	// Replaces the field with a memory mapped snapshot file. Fails without touching the field if the file is missing, from an
+	// older version, or was saved with a different key or sample resolution. OutSummary receives the summary it was saved with
+	bool MapFromFile(const FString& FilePath, uint64 Key, int32 ExpectedSampleRes, TArray<uint8>* OutSummary = nullptr);
+
+	static uint8 QuantizeValue(float Value) { return static_cast<uint8>(FMath::RoundToInt32(FMath::Clamp(Value, 0.0f, 1.0f) * 255.0f)); }
+	static float DequantizeValue(uint8 Value) { return Value / 255.0f; }
+
+private:
+
+	struct FBrick
+	{
+		// Value of every sample in the brick while PayloadIndex is INDEX_NONE
+		uint8 UniformValue = 255;
+
+		// Whether PayloadIndex refers to the mapped snapshot rather than Payloads
+		bool bMapped = false;
+
+		// Index of this brick's samples in Payloads, INDEX_NONE for uniform bricks
+		int32 PayloadIndex = INDEX_NONE;
+	};
+
+	// Snapshot file layout, followed by the brick payload indices, the brick uniform values, the caller's summary & then the
+	// payloads at PayloadOffset
+	struct FSnapshotHeader
+	{
+		uint32 Magic = 0;
+		uint32 Version = 0;
+		uint64 Key = 0;
+		int32 SampleRes = 0;
+		int32 BrickRes = 0;
+		int32 PayloadCount = 0;
+		int32 SummarySize = 0;
+		int64 PayloadOffset = 0;
+	};
+
+	static constexpr uint32 SnapshotMagic = 0x46535046; // 'FPSF'
+	static constexpr uint32 SnapshotVersion = 2;
+
+	int32 SampleRes = 0;
+	int32 BrickRes = 0;
+
+	TArray<FBrick> Bricks;
+
+	// BrickSampleCount quantized samples per payload
+	TArray<uint8> Payloads;
+	int32 PayloadCount = 0;
+
+	// Mapped snapshot the field was loaded from, if any. Its payloads are read only
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* MappedPayloads = nullptr;
+
+	int32 BrickIndex(const FIntVector& Brick) const { return Brick.X + (Brick.Y * BrickRes) + (Brick.Z * BrickRes * BrickRes); }
+
+	static int32 LocalSampleIndex(const FIntVector& Sample)
+	{
+		return (Sample.X & (BrickSize - 1)) + ((Sample.Y & (BrickSize - 1)) << BrickSizeLog2) + ((Sample.Z & (BrickSize - 1)) << (BrickSizeLog2 * 2));
+	}
+
+	const uint8* GetPayload(const FBrick& Brick) const
+	{
+		return Brick.bMapped ? MappedPayloads + (static_cast<int64>(Brick.PayloadIndex) * BrickSampleCount) : &Payloads[Brick.PayloadIndex * BrickSampleCount];
+	}
+
+	int32 AllocatePayload();
+};
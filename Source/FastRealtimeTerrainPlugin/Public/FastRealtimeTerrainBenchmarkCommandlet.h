@@ -0,0 +1,31 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FastRealtimeTerrainBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless throughput benchmark for endless terrain tiles & planet chunks. Builds a fixed seed matrix of terrain settings &
+ * writes samples/s, tiles or chunks/s, verts/s, p50/p99 build latency & peak memory for each to a JSON report. Given a
+ * baseline report, every metric is compared against it & the commandlet fails if any regresses past the tolerance.
+ *
+ * UnrealEditor-Cmd <Project>.uproject -run=FastRealtimeTerrainBenchmark -NullRHI -unattended
+ *     [-Output=<Report.json>] [-Baseline=<Report.json>] [-Tolerance=0.1] [-Iterations=3] [-Seed=1337] [-TileGrid=4]
+ *     [-EndlessClass=<Class Path>] [-PlanetClass=<Class Path>] [-SkipEndless] [-SkipPlanet]
+ *
+ * Noise layers come from the endless & planet classes, so pass Blueprint subclasses to benchmark a real noise setup. Without
+ * any, a single default noise layer is used.
+ */
+UCLASS()
+class FASTREALTIMETERRAINPLUGIN_API UFastRealtimeTerrainBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UFastRealtimeTerrainBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,25 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/**
+ * Helpers shared by the terrain benchmark & replay commandlets.
+ */
+class FASTREALTIMETERRAINPLUGIN_API FFastRealtimeTerrainCommandletUtils
+{
+public:
+
+	// Nearest rank percentile of values sorted ascending, so p99 of fewer than 100 values is the largest one
+	static double GetSortedPercentile(const TArray<double>& SortedValues, double Percentile);
+
+	// Creates a game world with its own world context, for terrain actors to spawn into & register their mesh comps with.
+	// Nothing is rendered under -NullRHI
+	static UWorld* CreateWorld(const TCHAR* WorldName);
+
+	// Destroys a world made by CreateWorld along with its world context
+	static void DestroyWorld(UWorld* World);
+};
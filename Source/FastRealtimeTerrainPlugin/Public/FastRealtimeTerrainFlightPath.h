@@ -0,0 +1,66 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPath.h"
+#include "FastRealtimeTerrainFlightPath.generated.h"
+
+// Everything a terrain actor was told to do between two of its ticks
+USTRUCT(BlueprintType)
+struct FASTREALTIMETERRAINPLUGIN_API FTerrainFlightPathFrame
+{
+	GENERATED_BODY()
+
+	// Delta the tick ending this frame ran with
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Replay")
+	float DeltaSeconds = 0.0f;
+
+	// Whether UpdateObserverPosition was called during the frame, ObserverLocation is the last location it was called with
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Replay")
+	bool bObserverUpdated = false;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Replay")
+	FVector ObserverLocation = FVector::ZeroVector;
+
+	// Planet edits made during the frame as an edit journal range, empty if there weren't any
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Replay")
+	TArray<uint8> EditJournal;
+};
+
+/**
+ * Observer movement & planet edits recorded from a terrain actor tick by tick, along with the actor's class & settings, so
+ * the same route can be replayed headless with the FastRealtimeTerrainReplay commandlet & streaming changes compared on it.
+ */
+USTRUCT(BlueprintType)
+struct FASTREALTIMETERRAINPLUGIN_API FTerrainFlightPath
+{
+	GENERATED_BODY()
+
+	// Class of the recorded actor, replays spawn the same class so Blueprint defaults like noise layers carry over
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Replay")
+	FSoftClassPath ActorClass;
+
+	// The recorded actor's terrain settings as text, by property name
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Replay")
+	TMap<FString, FString> Settings;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Replay")
+	TArray<FTerrainFlightPathFrame> Frames;
+
+	// Records Terrain's class & every terrain setting it declares, skipping the ones it inherits from the realtime mesh actor
+	void CaptureSettings(const AActor* Terrain);
+
+	// Copies the captured settings onto Terrain, which should be a freshly spawned ActorClass
+	void ApplySettings(AActor* Terrain) const;
+
+	bool SaveToFile(const FString& FilePath) const;
+
+	// Returns false if the file is missing or isn't a flight path this version can read
+	bool LoadFromFile(const FString& FilePath);
+
+private:
+
+	static constexpr uint32 Magic = 0x50465446; // 'FTFP'
+	static constexpr uint8 Version = 1;
+};
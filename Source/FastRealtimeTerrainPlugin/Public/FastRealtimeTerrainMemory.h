@@ -0,0 +1,62 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FastRealtimeTerrainMemory.generated.h"
+
+/**
+ * Bytes held by a terrain tile, chunk or whole terrain actor, broken down by what they're for. Use the Terrain.MemReport
+ * console command to log them for every terrain actor in the world.
+ */
+USTRUCT(BlueprintType)
+struct FASTREALTIMETERRAINPLUGIN_API FTerrainMemoryUsage
+{
+	GENERATED_BODY()
+
+	// Position, tangent, texcoord & color streams
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	int64 VertexBytes = 0;
+
+	// Triangle & polygroup streams
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	int64 IndexBytes = 0;
+
+	// Estimated from the triangle mesh the collision cook builds out of each collision section, the cook's own acceleration
+	// structures aren't included
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	int64 CollisionBytes = 0;
+
+	// Scalar field & cube data the mesh is built from
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Stats")
+	int64 FieldBytes = 0;
+
+	int64 GetTotalBytes() const { return VertexBytes + IndexBytes + CollisionBytes + FieldBytes; }
+
+	FTerrainMemoryUsage& operator+=(const FTerrainMemoryUsage& Other)
+	{
+		VertexBytes += Other.VertexBytes;
+		IndexBytes += Other.IndexBytes;
+		CollisionBytes += Other.CollisionBytes;
+		FieldBytes += Other.FieldBytes;
+		return *this;
+	}
+
+	FTerrainMemoryUsage& operator-=(const FTerrainMemoryUsage& Other)
+	{
+		VertexBytes -= Other.VertexBytes;
+		IndexBytes -= Other.IndexBytes;
+		CollisionBytes -= Other.CollisionBytes;
+		FieldBytes -= Other.FieldBytes;
+		return *this;
+	}
+
+	// Usage of a mesh section written with the stream layouts every terrain actor uses
+	static FTerrainMemoryUsage ForMeshSection(int32 VertexCount, int32 TriangleCount, bool bCollision);
+
+	// Replaces Peak with Current if Current's total is higher, so the peak is always a usage the terrain actually had
+	static void UpdatePeak(const FTerrainMemoryUsage& Current, FTerrainMemoryUsage& Peak);
+
+	// Logs a single report line prefixed with Label
+	void Report(FOutputDevice& Ar, const FString& Label) const;
+};
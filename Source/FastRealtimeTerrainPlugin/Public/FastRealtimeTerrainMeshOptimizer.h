@@ -0,0 +1,44 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RealtimeMeshSimple.h"
+
+/**
+ * Draw order for a mesh's triangles & verts, reordered for the GPU's post-transform vertex cache & vertex fetch. Every mesh
+ * with the same triangle topology can share one.
+ */
+struct FTerrainMeshOptimizedOrder
+{
+	// Triangle corners in their new draw order, indexing verts in their new order
+	TArray<uint32> Indices;
+
+	// Original index of each triangle, in its new draw order
+	TArray<int32> TriangleOrder;
+
+	// Original index of each vert, in its new order
+	TArray<int32> VertexOrder;
+};
+
+/**
+ * Stateless post-pass over built terrain streams, safe to run from any thread. Triangles are reordered with Tom Forsyth's
+ * linear-speed vertex cache optimisation, then verts are reordered by first use so the reordered triangles fetch them as
+ * close to sequentially as they can.
+ */
+class FASTREALTIMETERRAINPLUGIN_API FFastRealtimeTerrainMeshOptimizer
+{
+public:
+
+	// Works out the optimized order for a triangle list, Indices holding 3 corners per triangle
+	static void Optimize(const TArray<uint32>& Indices, int32 VertexCount, FTerrainMeshOptimizedOrder& OutOrder);
+
+	// Reorders a stream set's triangle, polygroup & vertex streams into Order, which must have been worked out from the same topology
+	static void ApplyOrder(FRealtimeMeshStreamSet& StreamSet, const FTerrainMeshOptimizedOrder& Order);
+
+	// Optimizes a built stream set in place
+	static void OptimizeStreamSet(FRealtimeMeshStreamSet& StreamSet);
+
+	// Number of verts the optimizer models the post-transform cache as holding
+	static constexpr int32 CacheSize = 32;
+};
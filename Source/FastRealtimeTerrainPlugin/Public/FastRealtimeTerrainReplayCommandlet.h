@@ -0,0 +1,31 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FastRealtimeTerrainReplayCommandlet.generated.h"
+
+/**
+ * Replays a flight path recorded with StartFlightRecording against a freshly spawned terrain actor of the recorded class &
+ * settings, feeding it the same observer updates & edits frame by frame. Writes the distribution of per-frame terrain cost,
+ * the worst frame, pending tile or chunk count every frame & how long the ground under the observer took to build to a
+ * JSON report. Planets are generated with GenerateMeshDeferred before the first frame.
+ *
+ * UnrealEditor-Cmd <Project>.uproject -run=FastRealtimeTerrainReplay -NullRHI -unattended -FlightPath=<Path>
+ *     [-Output=<Report.json>] [-SyncBuilds] [-RealTime]
+ *
+ * -SyncBuilds meshes planet chunks on the game thread so replays are fully deterministic, -RealTime sleeps out the rest of
+ * each recorded frame so async builds get the same wall time to finish in as they did while recording.
+ */
+UCLASS()
+class FASTREALTIMETERRAINPLUGIN_API UFastRealtimeTerrainReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UFastRealtimeTerrainReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,91 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+// Everything the terrain actors & the chunk mesher report, see it in game with "stat FastRealtimeTerrain"
+DECLARE_STATS_GROUP(TEXT("FastRealtimeTerrain"), STATGROUP_FastRealtimeTerrain, STATCAT_Advanced);
+
+// Low level memory tracker tag for everything the terrain allocates, see it with -llm & "stat LLMFULL"
+LLM_DECLARE_TAG_API(FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+
+// Trace channel the stage scopes below are emitted on, enable it for Insights with -trace=cpu,FastRealtimeTerrain
+UE_TRACE_CHANNEL_EXTERN(FastRealtimeTerrainChannel, FASTREALTIMETERRAINPLUGIN_API);
+
+// Game thread work
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick"), STAT_TerrainTick, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Schedule"), STAT_TerrainSchedule, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tile Build"), STAT_TerrainTileBuild, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Noise Sampling"), STAT_TerrainNoiseSampling, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Far Field Build"), STAT_TerrainFarFieldBuild, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Edit Apply"), STAT_TerrainEditApply, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Octree Update"), STAT_TerrainOctreeUpdate, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Chunk Snapshot"), STAT_TerrainChunkSnapshot, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Section Commit"), STAT_TerrainSectionCommit, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+
+// Collision is cooked asynchronously inside the realtime mesh, this only covers handing it the sections to cook
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Collision Update"), STAT_TerrainCollisionUpdate, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+
+// Meshing, on worker tasks for async planet chunk builds
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Chunk Build"), STAT_TerrainChunkBuild, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Classification"), STAT_TerrainClassification, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Stream Build"), STAT_TerrainStreamBuild, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Index Build"), STAT_TerrainIndexBuild, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Skirts"), STAT_TerrainSkirts, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mesh Optimize"), STAT_TerrainMeshOptimize, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+
+// Stages run in turn over each row of verts within a tile's stream build, timed with FTerrainStageTimer
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Tile Noise Sampling (ms)"), STAT_TerrainTileNoiseSampling, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Tile Smoothing (ms)"), STAT_TerrainTileSmoothing, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Tile Normals (ms)"), STAT_TerrainTileNormals, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+
+// Queue depths at the end of each tick, summed over every terrain actor
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pending Tiles"), STAT_TerrainPendingTiles, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pending Chunks"), STAT_TerrainPendingChunks, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("In Flight Chunk Builds"), STAT_TerrainInFlightBuilds, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Applied Edits"), STAT_TerrainAppliedEdits, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+
+// Per-frame build budgets & how much of them was spent, summed over every terrain actor & the shared scheduler budget
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Budget (ms)"), STAT_TerrainBudget, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Budget Used (ms)"), STAT_TerrainBudgetUsed, STATGROUP_FastRealtimeTerrain, FASTREALTIMETERRAINPLUGIN_API);
+
+// Times the rest of the enclosing scope as a terrain stage, both as STAT_Terrain<Name> & as a FastRealtimeTerrain_<Name>
+// trace event
+#define TERRAIN_STAGE_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Terrain##Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FastRealtimeTerrain_##Name, FastRealtimeTerrainChannel)
+
+/**
+ * Running total for a stage that's interleaved with others in small pieces, such as a pass over each row of a tile, where
+ * a stage scope around every piece would flood the stats & trace. Each piece of the stage is wrapped in a
+ * TERRAIN_STAGE_TIMER_SCOPE, & the total is added to its float counter stat with TERRAIN_STAGE_TIMER_FLUSH once the loop is
+ * done. Keep pieces coarse, as each scope reads the cycle counter twice.
+ */
+struct FTerrainStageTimer
+{
+#if STATS
+	uint64 Cycles = 0;
+
+	struct FScope
+	{
+		explicit FScope(FTerrainStageTimer& InTimer) : Timer(InTimer), StartCycles(FPlatformTime::Cycles64()) {}
+		~FScope() { Timer.Cycles += FPlatformTime::Cycles64() - StartCycles; }
+
+		FTerrainStageTimer& Timer;
+		uint64 StartCycles;
+	};
+#else
+	struct FScope
+	{
+		explicit FScope(FTerrainStageTimer&) {}
+	};
+#endif
+};
+
+#define TERRAIN_STAGE_TIMER_SCOPE(Timer) FTerrainStageTimer::FScope ANONYMOUS_VARIABLE(TerrainStageTimer)(Timer)
+#define TERRAIN_STAGE_TIMER_FLUSH(Name, Timer) INC_FLOAT_STAT_BY(STAT_Terrain##Name, FPlatformTime::ToMilliseconds64(Timer.Cycles))
@@ -0,0 +1,113 @@
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FastRealtimeTerrainSubsystem.generated.h"
+
+// One frame as measured by the quality governor, & what it had settled on by the end of it
+USTRUCT(BlueprintType)
+struct FASTREALTIMETERRAINPLUGIN_API FTerrainGovernorSample
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Quality")
+	float FrameMs = 0.0f;
+
+	// Scheduled terrain work the frame did
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Quality")
+	float TerrainMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Quality")
+	float BudgetMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Terrain|Quality")
+	float QualityLevel = 0.0f;
+};
+
+/**
+ * Shares one per-frame build budget between every terrain actor in the world, so the cost of building terrain stays the same
+ * no matter how many terrain actors are placed. Actors with bUseTerrainScheduler set stop spending their own budgets on tick,
+ * & are instead given slices of Terrain.Scheduler.BudgetMs each frame, weighted by their SchedulerPriority & how close their
+ * pending work is to their observer. Actors that miss out on a frame's budget get more weight every frame until they don't.
+ *
+ * With Terrain.Governor.Enable set, it also governs terrain quality to hold Terrain.Governor.TargetFPS. The shared budget
+ * follows the frame time left over once everything but terrain work is paid for, within Terrain.Governor.MinBudgetMs &
+ * MaxBudgetMs, & a quality level moves each opted in actor's streaming radius & LOD thresholds between its designer set
+ * bounds. Actors get their own settings back as soon as they opt out or the governor is disabled. Quality only steps once
+ * the smoothed frame time has sat outside a dead band around the target for a number of frames, stepping down faster than
+ * it steps back up, so it settles rather than oscillating.
+ */
+UCLASS()
+class FASTREALTIMETERRAINPLUGIN_API UFastRealtimeTerrainSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Terrain actors tick in editor viewports, so their scheduled work has to as well
+	virtual bool IsTickableInEditor() const override { return true; }
+
+	// Whether terrain actors in World that opt in should leave their pending work to its subsystem
+	static bool IsSchedulingEnabled(const UWorld* World);
+
+	// Shared budget for the next frame in milliseconds, defaults to Terrain.Scheduler.BudgetMs
+	float GetFrameBudgetMs() const;
+
+	// Overrides Terrain.Scheduler.BudgetMs for this world, a negative budget clears the override
+	void SetFrameBudgetMs(float BudgetMs) { FrameBudgetOverrideMs = BudgetMs; }
+
+	// Milliseconds the last frame's scheduled terrain work took
+	float GetLastFrameUsedMs() const { return LastFrameUsedMs; }
+
+	// Quality level the governor has settled on, 0 = every governed setting at its lowest quality bound, 1 = at its highest
+	UFUNCTION(BlueprintPure, Category = "Terrain|Quality")
+	float GetQualityLevel() const { return QualityLevel; }
+
+	// Frames the governor has measured, oldest first, up to Terrain.Governor.HistoryLength of them
+	UFUNCTION(BlueprintCallable, Category = "Terrain|Quality")
+	void GetGovernorHistory(TArray<FTerrainGovernorSample>& OutHistory) const;
+
+private:
+
+	// Measures the last frame & steps the budget & quality level, before this frame's budget is handed out
+	void UpdateQualityGovernor();
+
+	// Pushes QualityLevel to every opted in terrain actor, & gives opted out ones back their own settings
+	void ApplyQualityLevel();
+
+	// Gives every terrain actor back the settings the governor replaced
+	void RestoreUngovernedQuality();
+
+	bool bGovernorActive = false;
+
+	// Wall clock time of the last governor update. Frames are measured in real time, as the world's delta time is dilated,
+	// clamped & fixed by replays
+	double LastGovernorUpdateSeconds = 0.0;
+
+	float QualityLevel = 1.0f;
+
+	float SmoothedFrameMs = 0.0f;
+
+	float SmoothedTerrainMs = 0.0f;
+
+	// Consecutive frames the smoothed frame time has been above or below the dead band around the target
+	int32 FramesOverTarget = 0;
+	int32 FramesUnderTarget = 0;
+
+	// Ring buffer of measured frames, GovernorHistoryHead is the next slot to write once it's full
+	TArray<FTerrainGovernorSample> GovernorHistory;
+	int32 GovernorHistoryHead = 0;
+
+	float FrameBudgetOverrideMs = -1.0f;
+
+	float LastFrameUsedMs = 0.0f;
+
+	// Consecutive frames each actor has had pending work without being given any of the budget
+	TMap<TWeakObjectPtr<AActor>, int32> StarvedFrames;
+};